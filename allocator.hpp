@@ -1,78 +1,749 @@
 #ifndef STLITE_ALLOCATOR_HPP
 #define STLITE_ALLOCATOR_HPP
 
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "utilities.hpp"
+#include "allocator_stats.hpp"
 
 namespace s7a9 {
+    // Memory policy: malloc(), realloc() and free()
+    // A memory policy supplies raw blocks to __slot_allocator. Its copy starts
+    // with no blocks, and reallocate() is only used for bitwise relocatable data.
+    // resize_in_place() must not move the block and returns false if it cannot.
+    class __malloc_memory {
+    public:
+        inline void* allocate(size_t bytes) noexcept {
+            return malloc(bytes);
+        }
+
+        inline void* reallocate(void* p, size_t, size_t bytes) noexcept {
+            return realloc(p, bytes);
+        }
+
+        inline bool resize_in_place(void*, size_t, size_t) noexcept {
+            return false;
+        }
+
+        inline void deallocate(void* p, size_t) noexcept {
+            free(p);
+        }
+
+        inline void swap(__malloc_memory&) noexcept {}
+    };
+
+    // Monotonic arena
+    // Memory is bumped out of chunks that grow geometrically from MIN_CHUNK to
+    // MAX_CHUNK bytes; single blocks cannot be freed, and release() drops every
+    // chunk at once. Only the most recent block can grow in place.
+    class __monotonic_arena {
+    private:
+        struct chunk_t {
+            chunk_t* next;
+        };
+
+        static constexpr size_t MIN_CHUNK = 4096, MAX_CHUNK = 1 << 20,
+            ALIGN = alignof(std::max_align_t),
+            CHUNK_HEADER = (sizeof(chunk_t) + ALIGN - 1) / ALIGN * ALIGN;
+
+        chunk_t* _chunks;
+
+        char* _cur, * _lim; // Free part of the newest chunk
+
+        char* _last; // The most recent block
+
+        size_t _chunk_size; // Size of the next chunk
+
+        static inline char* _align_up(char* p, size_t align) noexcept {
+            return reinterpret_cast<char*>((reinterpret_cast<size_t>(p) + align - 1) & ~(align - 1));
+        }
+
+        bool _new_chunk(size_t bytes, size_t align) noexcept {
+            size_t size = _chunk_size;
+            while (size < CHUNK_HEADER + bytes + align) size *= 2;
+            chunk_t* chunk = static_cast<chunk_t*>(malloc(size));
+            if (chunk == nullptr) return false;
+            chunk->next = _chunks, _chunks = chunk;
+            _cur = reinterpret_cast<char*>(chunk) + CHUNK_HEADER;
+            _lim = reinterpret_cast<char*>(chunk) + size;
+            if (_chunk_size < MAX_CHUNK) _chunk_size *= 2;
+            return true;
+        }
+
+    public:
+        __monotonic_arena() noexcept :
+            _chunks(nullptr), _cur(nullptr), _lim(nullptr), _last(nullptr), _chunk_size(MIN_CHUNK) {}
+
+        // an arena is never shared, so a copy starts empty
+        __monotonic_arena(const __monotonic_arena&) noexcept :
+            __monotonic_arena() {}
+
+        __monotonic_arena(__monotonic_arena&& x) noexcept :
+            _chunks(x._chunks), _cur(x._cur), _lim(x._lim), _last(x._last), _chunk_size(x._chunk_size) {
+            x._chunks = nullptr;
+            x._cur = x._lim = x._last = nullptr;
+            x._chunk_size = MIN_CHUNK;
+        }
+
+        ~__monotonic_arena() {
+            release();
+        }
+
+        // empty blocks get nullptr, otherwise one would share its address with
+        // the next block and could later grow in place over it
+        void* allocate(size_t bytes, size_t align = ALIGN) noexcept {
+            if (bytes == 0) return nullptr;
+            char* p = _align_up(_cur, align);
+            if (_cur == nullptr || p > _lim || static_cast<size_t>(_lim - p) < bytes) {
+                if (!_new_chunk(bytes, align)) return nullptr;
+                p = _align_up(_cur, align);
+            }
+            _cur = p + bytes;
+            return _last = p;
+        }
+
+        // resize block p without moving it, only possible for the most recent block
+        inline bool resize_in_place(void* p, size_t bytes) noexcept {
+            if (p == nullptr || p != _last || static_cast<size_t>(_lim - _last) < bytes) return false;
+            _cur = _last + bytes;
+            return true;
+        }
+
+        // grow or shrink block p of old_bytes, in place if it is the most recent block
+        void* reallocate(void* p, size_t old_bytes, size_t bytes, size_t align = ALIGN) noexcept {
+            if (resize_in_place(p, bytes)) return p;
+            void* ret = allocate(bytes, align);
+            if (ret && p) memcpy(ret, p, val_min(old_bytes, bytes));
+            return ret;
+        }
+
+        // free every chunk at once
+        void release() noexcept {
+            while (_chunks) {
+                chunk_t* nxt = _chunks->next;
+                free(_chunks);
+                _chunks = nxt;
+            }
+            _cur = _lim = _last = nullptr;
+            _chunk_size = MIN_CHUNK;
+        }
+
+        // take over the chunks of other; its blocks stay valid
+        void merge(__monotonic_arena& other) noexcept {
+            if (this == &other || other._chunks == nullptr) return;
+            chunk_t* tail = other._chunks;
+            while (tail->next) tail = tail->next;
+            tail->next = _chunks, _chunks = other._chunks;
+            _cur = other._cur, _lim = other._lim, _last = other._last;
+            other._chunks = nullptr;
+            other._cur = other._lim = other._last = nullptr;
+            other._chunk_size = MIN_CHUNK;
+        }
+
+        inline void swap(__monotonic_arena& other) noexcept {
+            s7a9::swap(_chunks, other._chunks);
+            s7a9::swap(_cur, other._cur);
+            s7a9::swap(_lim, other._lim);
+            s7a9::swap(_last, other._last);
+            s7a9::swap(_chunk_size, other._chunk_size);
+        }
+    };
+
+    // Memory policy: monotonic arena owned by the allocator
+    // deallocate() is a no-op; the whole region goes away with the allocator.
+    class __arena_memory {
+    private:
+        __monotonic_arena _arena;
+
+    public:
+        inline void* allocate(size_t bytes) noexcept {
+            return _arena.allocate(bytes);
+        }
+
+        inline void* reallocate(void* p, size_t old_bytes, size_t bytes) noexcept {
+            return _arena.reallocate(p, old_bytes, bytes);
+        }
+
+        inline bool resize_in_place(void* p, size_t, size_t bytes) noexcept {
+            return _arena.resize_in_place(p, bytes);
+        }
+
+        inline void deallocate(void*, size_t) noexcept {}
+
+        inline void swap(__arena_memory& other) noexcept {
+            _arena.swap(other._arena);
+        }
+    };
+
+#ifdef __linux__
+    // Memory policy: anonymous mappings for large blocks
+    // Blocks of at least MMAP_THRESHOLD bytes get their own mapping, aligned to
+    // HUGE_PAGE and marked MADV_HUGEPAGE once they span a huge page. They grow
+    // and shrink with mremap(), so relocating a large buffer moves page tables
+    // instead of copying it and never holds two copies at once; shrinking
+    // unmaps the tail. Smaller blocks fall back to malloc(). The path is chosen
+    // by size alone, so callers must pass the exact size of each block.
+    class __mmap_memory {
+    private:
+        static constexpr size_t MMAP_THRESHOLD = 256 * 1024, HUGE_PAGE = 2 * 1024 * 1024;
+
+        static inline size_t _page_size() noexcept {
+            static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return page;
+        }
+
+        static inline size_t _map_len(size_t bytes) noexcept {
+            return (bytes + _page_size() - 1) / _page_size() * _page_size();
+        }
+
+        static inline bool _mapped(size_t bytes) noexcept {
+            return bytes >= MMAP_THRESHOLD;
+        }
+
+        static inline void _advise(void* p, size_t len) noexcept {
+#ifdef MADV_HUGEPAGE
+            if (len >= HUGE_PAGE) madvise(p, len, MADV_HUGEPAGE);
+#endif
+        }
+
+        static void* _map(size_t bytes) noexcept {
+            size_t len = _map_len(bytes), extra = len >= HUGE_PAGE ? HUGE_PAGE : 0;
+            void* mem = mmap(nullptr, len + extra, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) return nullptr;
+            char* p = static_cast<char*>(mem);
+            if (extra) { // trim the mapping to a huge page boundary
+                char* aligned = reinterpret_cast<char*>(
+                    (reinterpret_cast<size_t>(p) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1));
+                if (aligned > p) munmap(p, aligned - p);
+                if (p + extra > aligned) munmap(aligned + len, p + extra - aligned);
+                p = aligned;
+            }
+            _advise(p, len);
+            return p;
+        }
+
+    public:
+        inline void* allocate(size_t bytes) noexcept {
+            return _mapped(bytes) ? _map(bytes) : malloc(bytes);
+        }
+
+        void* reallocate(void* p, size_t old_bytes, size_t bytes) noexcept {
+            if (p == nullptr) return allocate(bytes);
+            if (_mapped(old_bytes) && _mapped(bytes)) {
+                size_t old_len = _map_len(old_bytes), len = _map_len(bytes);
+                if (old_len == len) return p;
+                void* ret = mremap(p, old_len, len, MREMAP_MAYMOVE);
+                if (ret == MAP_FAILED) return nullptr;
+                if (len > old_len) _advise(ret, len);
+                return ret;
+            }
+            if (!_mapped(old_bytes) && !_mapped(bytes)) return realloc(p, bytes);
+            void* ret = allocate(bytes);
+            if (ret) {
+                memcpy(ret, p, val_min(old_bytes, bytes));
+                deallocate(p, old_bytes);
+            }
+            return ret;
+        }
+
+        bool resize_in_place(void* p, size_t old_bytes, size_t bytes) noexcept {
+            if (p == nullptr || !_mapped(old_bytes) || !_mapped(bytes)) return false;
+            size_t old_len = _map_len(old_bytes), len = _map_len(bytes);
+            if (old_len != len && mremap(p, old_len, len, 0) == MAP_FAILED) return false;
+            if (len > old_len) _advise(p, len);
+            return true;
+        }
+
+        inline void deallocate(void* p, size_t bytes) noexcept {
+            if (p == nullptr) return;
+            if (_mapped(bytes)) munmap(p, _map_len(bytes));
+            else free(p);
+        }
+
+        inline void swap(__mmap_memory&) noexcept {}
+    };
+#endif
+
+    // Memory policy: blocks aligned to Align bytes
+    // Align is a power of two, e.g. 32 for AVX loads or 64 for a cache line.
+    // Block sizes are rounded up to a multiple of Align, so whole vectors may
+    // be loaded up to the rounded end. With Padded, blocks are also aligned
+    // and rounded to CACHE_LINE, so blocks written by different threads never
+    // share a cache line.
+    template <size_t Align = 64, bool Padded = false>
+    class __aligned_memory {
+    public:
+        static constexpr size_t CACHE_LINE = 64;
+
+        static constexpr size_t ALIGNMENT = Padded && Align < CACHE_LINE ? CACHE_LINE : Align;
+
+    private:
+        static_assert(Align && (Align & (Align - 1)) == 0, "__aligned_memory: Align must be a power of two");
+
+        static inline size_t _round(size_t bytes) noexcept {
+            return bytes ? (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT : ALIGNMENT;
+        }
+
+        static inline bool _aligned(void* p) noexcept {
+            return (reinterpret_cast<size_t>(p) & (ALIGNMENT - 1)) == 0;
+        }
+
+    public:
+        inline void* allocate(size_t bytes) noexcept {
+#ifdef _MSC_VER
+            return _aligned_malloc(_round(bytes), ALIGNMENT);
+#else
+            return aligned_alloc(ALIGNMENT, _round(bytes));
+#endif
+        }
+
+        // realloc() keeps the block when it can grow in place; a block it moved
+        // to a misaligned address is copied once more
+        void* reallocate(void* p, size_t old_bytes, size_t bytes) noexcept {
+#ifdef _MSC_VER
+            return _aligned_realloc(p, _round(bytes), ALIGNMENT);
+#else
+            if (p == nullptr) return allocate(bytes);
+            void* ret = realloc(p, _round(bytes));
+            if (ret == nullptr || _aligned(ret)) return ret;
+            void* aligned = allocate(bytes);
+            if (aligned) memcpy(aligned, ret, val_min(old_bytes, bytes));
+            free(ret);
+            return aligned;
+#endif
+        }
+
+        inline bool resize_in_place(void*, size_t old_bytes, size_t bytes) noexcept {
+            return _round(old_bytes) == _round(bytes);
+        }
+
+        inline void deallocate(void* p, size_t) noexcept {
+#ifdef _MSC_VER
+            _aligned_free(p);
+#else
+            free(p);
+#endif
+        }
+
+        inline void swap(__aligned_memory&) noexcept {}
+    };
+
+    // Memory policy: room for two blocks inside the policy object
+    // A block of up to DataBytes (the slots) and one of up to MapBytes (the
+    // usage bitmap) are served from inline buffers, so a small container needs
+    // no heap allocation; larger blocks come from malloc(), and a block that
+    // shrinks back into a free buffer returns there. Inline blocks live and die
+    // with the object, so __slot_allocator moves and swaps their elements
+    // instead of the block pointers.
+    template <size_t DataBytes, size_t MapBytes>
+    class __inline_memory {
+    private:
+        alignas(std::max_align_t) unsigned char _data_buf[DataBytes];
+
+        alignas(std::max_align_t) unsigned char _map_buf[MapBytes];
+
+        bool _data_busy, _map_busy;
+
+        // the smallest free buffer that fits bytes, or nullptr
+        void* _take(size_t bytes) noexcept {
+            bool data_fits = !_data_busy && bytes <= DataBytes,
+                map_fits = !_map_busy && bytes <= MapBytes;
+            if (map_fits && (!data_fits || MapBytes < DataBytes)) {
+                _map_busy = true;
+                return _map_buf;
+            }
+            if (data_fits) {
+                _data_busy = true;
+                return _data_buf;
+            }
+            return nullptr;
+        }
+
+        inline size_t _inline_size(const void* p) const noexcept {
+            return p == _data_buf ? DataBytes : MapBytes;
+        }
+
+        inline void _give_back(const void* p) noexcept {
+            if (p == _data_buf) _data_busy = false;
+            else _map_busy = false;
+        }
+
+    public:
+        static constexpr size_t INLINE_BYTES = DataBytes;
+
+        __inline_memory() noexcept :
+            _data_busy(false), _map_busy(false) {}
+
+        // the buffers belong to this object, a copy starts with both free
+        __inline_memory(const __inline_memory&) noexcept :
+            __inline_memory() {}
+
+        __inline_memory& operator=(const __inline_memory&) = delete;
+
+        // whether p is one of the inline buffers
+        inline bool owns(const void* p) const noexcept {
+            return p == _data_buf || p == _map_buf;
+        }
+
+        inline void* allocate(size_t bytes) noexcept {
+            void* p = _take(bytes);
+            return p ? p : malloc(bytes);
+        }
+
+        void* reallocate(void* p, size_t old_bytes, size_t bytes) noexcept {
+            if (owns(p)) {
+                if (bytes <= _inline_size(p)) return p;
+                void* ret = malloc(bytes);
+                if (ret == nullptr) return nullptr;
+                memcpy(ret, p, val_min(old_bytes, bytes));
+                _give_back(p);
+                return ret;
+            }
+            if (p) {
+                void* ret = _take(bytes);
+                if (ret) {
+                    memcpy(ret, p, val_min(old_bytes, bytes));
+                    free(p);
+                    return ret;
+                }
+            }
+            return realloc(p, bytes);
+        }
+
+        inline bool resize_in_place(void* p, size_t, size_t bytes) noexcept {
+            return owns(p) && bytes <= _inline_size(p);
+        }
+
+        inline void deallocate(void* p, size_t) noexcept {
+            if (owns(p)) _give_back(p);
+            else free(p);
+        }
+    };
+
+    // Bytes of slots a memory policy or slot allocator keeps inline, read from
+    // its INLINE_BYTES member if it declares one
+    template <class T, class = void>
+    struct __inline_bytes : std::integral_constant<size_t, 0> {};
+
+    template <class T>
+    struct __inline_bytes<T, std::void_t<decltype(T::INLINE_BYTES)>> :
+        std::integral_constant<size_t, T::INLINE_BYTES> {};
+
+    // Alignment of the blocks handed out by a memory policy or slot allocator,
+    // read from its ALIGNMENT member if it declares one
+    template <class T, class = void>
+    struct __block_alignment : std::integral_constant<size_t, alignof(std::max_align_t)> {};
+
+    template <class T>
+    struct __block_alignment<T, std::void_t<decltype(T::ALIGNMENT)>> :
+        std::integral_constant<size_t, T::ALIGNMENT> {};
+
+    // Whether an allocator keeps its slots in one array, so that data(0) + idx
+    // addresses slot idx; read from its CONTIGUOUS member
+    template <class Allocator, class = void>
+    struct __is_contiguous : std::false_type {};
+
+    template <class Allocator>
+    struct __is_contiguous<Allocator, std::void_t<decltype(Allocator::CONTIGUOUS)>> :
+        std::integral_constant<bool, Allocator::CONTIGUOUS> {};
+
+    // Wrapper that gives value a cache line of its own
+    // e.g. an array of cache_padded<vector<T>>, one per thread, keeps the size
+    // and pointer fields of neighbouring vectors from false sharing.
+    template <class T>
+    struct alignas(__aligned_memory<>::CACHE_LINE) cache_padded {
+        T value;
+
+        inline T& operator*() noexcept {
+            return value;
+        }
+
+        inline const T& operator*() const noexcept {
+            return value;
+        }
+
+        inline T* operator->() noexcept {
+            return &value;
+        }
+
+        inline const T* operator->() const noexcept {
+            return &value;
+        }
+    };
+
     // Basic allocator
-    template <class elemType>
-    class __malloc_allocator {
+    // Slots live in one block obtained from the Memory policy. Trivially copyable
+    // elements are relocated with reallocate()/memcpy()/memmove() instead of one
+    // constructor and destructor call per slot.
+    template <class elemType, class Memory = __malloc_memory>
+    class __slot_allocator {
     private:
+        typedef unsigned long long word_t;
+
+        static constexpr size_t WORD_BITS = 64;
+
+        static constexpr bool TRIVIAL = std::is_trivially_copyable<elemType>::value;
+
+    public:
+        static constexpr size_t ALIGNMENT = __block_alignment<Memory>::value;
+
+        static constexpr bool CONTIGUOUS = true;
+
+        static constexpr size_t INLINE_BYTES = __inline_bytes<Memory>::value;
+
+    private:
+        static constexpr bool INLINE = INLINE_BYTES > 0;
+
         elemType* _data; // First address of all data
 
-        bool* _used;
+        word_t* _used; // One bit per slot, set if the slot holds a value
 
         size_t _num; // Total size
 
-    public:
-        // use malloc() to allocate a piece of memory
-        explicit __malloc_allocator(const size_t num) noexcept :
-            _num(num) {
-            _used = static_cast<bool*>(calloc(num, sizeof(bool)));
-            _data = static_cast<elemType*>(calloc(num, sizeof(elemType)));
+        Memory _mem;
+
+        STLITE_STATS(__stats_counter _counter{ "slot_allocator" };)
+
+        static inline size_t _word_num(size_t num) noexcept {
+            return (num + WORD_BITS - 1) / WORD_BITS;
         }
 
-        // copy constructor
-        __malloc_allocator(const __malloc_allocator& x) {
-            _num = x._num;
-            _used = static_cast<bool*>(calloc(_num, sizeof(bool)));
-            _data = static_cast<elemType*>(calloc(_num, sizeof(elemType)));
-            for (size_t i = 0; i < _num; ++i) {
-                if (x.has_value(i)) {
-                    new(_data + i) elemType(*x[i]);
-                    _used[i] = true;
+        // call func(idx) for every used slot in [first, lim), skipping empty words
+        template <class Func>
+        void _for_each_used(size_t first, size_t lim, Func func) const {
+            size_t words = _word_num(lim);
+            for (size_t w = first / WORD_BITS; w < words; ++w) {
+                word_t bits = _used[w];
+                if (w == first / WORD_BITS) bits &= ~word_t(0) << first % WORD_BITS;
+                if (w == lim / WORD_BITS) bits &= (word_t(1) << lim % WORD_BITS) - 1;
+                while (bits) {
+                    func(w * WORD_BITS + ctz64(bits));
+                    bits &= bits - 1;
                 }
             }
         }
 
-        // Move constructor
-        __malloc_allocator(__malloc_allocator&& x) noexcept {
+        template <class Func>
+        inline void _for_each_used(size_t lim, Func func) const {
+            _for_each_used(0, lim, func);
+        }
+
+        // set or clear the bits of slots [first, last)
+        void _set_bits(size_t first, size_t last, bool val) noexcept {
+            while (first < last) {
+                size_t w = first / WORD_BITS, off = first % WORD_BITS,
+                    len = val_min(WORD_BITS - off, last - first);
+                word_t mask = (len == WORD_BITS ? ~word_t(0) : (word_t(1) << len) - 1) << off;
+                if (val) _used[w] |= mask;
+                else _used[w] &= ~mask;
+                first += len;
+            }
+        }
+
+        void _destroy_all() noexcept {
+            if (std::is_trivially_destructible<elemType>::value) return;
+            _for_each_used(_num, [this](size_t i) {
+                (_data + i)->~elemType();
+            });
+        }
+
+        word_t* _new_bitmap(size_t num) {
+            size_t bytes = _word_num(num) * sizeof(word_t);
+            word_t* ret = static_cast<word_t*>(_mem.allocate(bytes));
+            if (ret && bytes) memset(ret, 0, bytes);
+            STLITE_STATS(if (ret) _counter.on_alloc(bytes);)
+            return ret;
+        }
+
+        elemType* _new_data(size_t num) {
+            void* ret = _mem.allocate(num * sizeof(elemType));
+            STLITE_STATS(if (ret) _counter.on_alloc(num * sizeof(elemType));)
+            return static_cast<elemType*>(ret);
+        }
+
+        // resize the bitmap to num slots, dropping the bits past the new end;
+        // return false and change nothing if memory runs out
+        bool _resize_bitmap(size_t num) noexcept {
+            size_t old_words = _word_num(_num), words = _word_num(num);
+            word_t* used = static_cast<word_t*>(
+                _mem.reallocate(_used, old_words * sizeof(word_t), words * sizeof(word_t)));
+            if (used == nullptr && words) return false;
+            _used = used;
+            STLITE_STATS(_counter.on_resize(old_words * sizeof(word_t), words * sizeof(word_t));)
+            if (words > old_words)
+                memset(_used + old_words, 0, (words - old_words) * sizeof(word_t));
+            else if (num % WORD_BITS)
+                _used[words - 1] &= (word_t(1) << num % WORD_BITS) - 1;
+            _num = num;
+            return true;
+        }
+
+        void _free_blocks() noexcept {
+            STLITE_STATS(if (_data) _counter.on_free(_num * sizeof(elemType));)
+            STLITE_STATS(if (_used) _counter.on_free(_word_num(_num) * sizeof(word_t));)
+            _mem.deallocate(_data, _num * sizeof(elemType));
+            _mem.deallocate(_used, _word_num(_num) * sizeof(word_t));
+        }
+
+        // take the blocks of x, or move its elements if a block lives inside x;
+        // this allocator must hold no blocks
+        void _take(__slot_allocator& x) {
+            if constexpr (INLINE) {
+                if (x._mem.owns(x._data) || x._mem.owns(x._used)) {
+                    _num = x._num;
+                    _used = _new_bitmap(_num);
+                    _data = _new_data(_num);
+                    if constexpr (TRIVIAL) {
+                        memcpy(_data, x._data, _num * sizeof(elemType));
+                        memcpy(_used, x._used, _word_num(_num) * sizeof(word_t));
+                    }
+                    else {
+                        x._for_each_used(_num, [this, &x](size_t i) {
+                            construct(i, Move(x._data[i]));
+                        });
+                    }
+                    x.clean();
+                    return;
+                }
+            }
             _data = x._data;
             _num = x._num;
             _used = x._used;
             x._data = nullptr;
             x._used = nullptr;
             x._num = 0;
+            STLITE_STATS(_counter.swap(x._counter);)
         }
 
-        // free all memory when being deconstructed
-        ~__malloc_allocator() {
-            for (size_t i = 0; i < _num; ++i) {
-                if (has_value(i))
-                    (_data + i)->~elemType();
+        // destroy every value and return both blocks
+        void _reset() noexcept {
+            _destroy_all();
+            _free_blocks();
+            _data = nullptr;
+            _used = nullptr;
+            _num = 0;
+        }
+
+        void _copy_from(const __slot_allocator& x) {
+            _used = _new_bitmap(_num);
+            _data = _new_data(_num);
+            if constexpr (TRIVIAL) {
+                if (_num) {
+                    memcpy(_data, x._data, _num * sizeof(elemType));
+                    memcpy(_used, x._used, _word_num(_num) * sizeof(word_t));
+                }
+            }
+            else {
+                x._for_each_used(_num, [this, &x](size_t i) {
+                    construct(i, *x[i]);
+                });
             }
-            free(_data);
-            free(_used);
         }
 
-        // resize the memory
+    public:
+        // take a block for num slots from the memory policy
+        explicit __slot_allocator(const size_t num) noexcept :
+            _num(num) {
+            _used = _new_bitmap(num);
+            _data = _new_data(num);
+        }
+
+        // take a block for num slots from a copy of mem
+        __slot_allocator(const size_t num, const Memory& mem) :
+            _num(num), _mem(mem) {
+            _used = _new_bitmap(num);
+            _data = _new_data(num);
+        }
+
+        // empty allocator of num slots drawing from the same memory as proto
+        __slot_allocator(const size_t num, const __slot_allocator& proto) :
+            __slot_allocator(num, proto._mem) {}
+
+        // copy constructor
+        __slot_allocator(const __slot_allocator& x) :
+            _num(x._num), _mem(x._mem) {
+            _copy_from(x);
+        }
+
+        // Move constructor
+        __slot_allocator(__slot_allocator&& x) noexcept(!INLINE || TRIVIAL ||
+            std::is_nothrow_move_constructible<elemType>::value) :
+            _mem(Move(x._mem)) {
+            _take(x);
+        }
+
+        // free all memory when being deconstructed
+        ~__slot_allocator() {
+            _destroy_all();
+            _free_blocks();
+        }
+
+        // resize the memory; return nullptr and keep the old blocks and values if
+        // memory runs out (a shrink may instead keep the old, larger block)
         elemType* reallocate(const size_t num) noexcept {
-            elemType* new_data = static_cast<elemType*>(calloc(num, sizeof(elemType)));
-            bool* new_used = static_cast<bool*>(calloc(num, sizeof(bool)));
-            size_t i;
-            for (i = 0; i < _num && i < num; ++i) {
-                if (has_value(i)) {
-                    new(new_data + i) elemType(Move(_data[i]));
-                    (_data + i)->~elemType();
-                    new_used[i] = true;
+            if constexpr (TRIVIAL) {
+                elemType* data = static_cast<elemType*>(
+                    _mem.reallocate(_data, _num * sizeof(elemType), num * sizeof(elemType)));
+                if (data == nullptr && num) return nullptr;
+                size_t old_bytes = _num * sizeof(elemType);
+                STLITE_STATS(size_t moved = data == _data ? 0 : val_min(_num, num) * sizeof(elemType);)
+                _data = data;
+                if (!_resize_bitmap(num)) {
+                    // put the slots back at their old size so the blocks stay consistent
+                    data = static_cast<elemType*>(_mem.reallocate(_data, num * sizeof(elemType), old_bytes));
+                    if (data || old_bytes == 0) _data = data;
+                    return nullptr;
                 }
+                STLITE_STATS(_counter.on_resize(old_bytes, num * sizeof(elemType));)
+                STLITE_STATS(_counter.on_relocate(moved);)
+                return _data;
             }
-            for (; i < _num; ++i) {
-                if (has_value(i)) (_data + i)->~elemType();
+            // the new bitmap comes first, so running out of memory destroys nothing
+            word_t* new_used = _new_bitmap(num);
+            if (new_used == nullptr && num) return nullptr;
+            size_t old_bytes = _num * sizeof(elemType), old_words = _word_num(_num);
+            // slots past the new end must be gone before the block may shrink in place
+            _for_each_used(num, _num, [this](size_t i) {
+                remove(i);
+            });
+            if (_mem.resize_in_place(_data, old_bytes, num * sizeof(elemType))) {
+                if (old_words && num)
+                    memcpy(new_used, _used, val_min(old_words, _word_num(num)) * sizeof(word_t));
+                STLITE_STATS(if (_used) _counter.on_free(old_words * sizeof(word_t));)
+                _mem.deallocate(_used, old_words * sizeof(word_t));
+                STLITE_STATS(_counter.on_resize(old_bytes, num * sizeof(elemType));)
+                STLITE_STATS(_counter.on_relocate(0);)
+                _used = new_used;
+                _num = num;
+                return _data;
             }
-            free(_data);
-            free(_used);
+            elemType* new_data = _new_data(num);
+            if (new_data == nullptr && num) {
+                STLITE_STATS(if (new_used) _counter.on_free(_word_num(num) * sizeof(word_t));)
+                _mem.deallocate(new_used, _word_num(num) * sizeof(word_t));
+                // a shrink has already dropped the slots past the new end and
+                // keeps the old block, which still holds the rest
+                return num < _num ? _data : nullptr;
+            }
+            STLITE_STATS(size_t moved = 0;)
+            _for_each_used(_num, [&](size_t i) {
+                if (i < num) {
+                    new(new_data + i) elemType(Move(_data[i]));
+                    new_used[i / WORD_BITS] |= word_t(1) << i % WORD_BITS;
+                    STLITE_STATS(moved += sizeof(elemType);)
+                }
+                (_data + i)->~elemType();
+            });
+            STLITE_STATS(_counter.on_relocate(moved);)
+            _free_blocks();
             _data = new_data;
             _num = num;
             _used = new_used;
@@ -104,25 +775,18 @@ namespace s7a9 {
             return _data;
         }*/
 
-        void copy(const __malloc_allocator& other) {
+        void copy(const __slot_allocator& other) {
             if (this == &other) return;
             clean();
-            free(_data), free(_used);
+            _free_blocks();
             _num = other._num;
-            _used = static_cast<bool*>(calloc(_num, sizeof(bool)));
-            _data = static_cast<elemType*>(calloc(_num, sizeof(elemType)));
-            for (size_t i = 0; i < _num; ++i) {
-                if (other.has_value(i)) {
-                    new(_data + i) elemType(*other[i]);
-                    _used[i] = true;
-                }
-            }
+            _copy_from(other);
         }
 
         inline void remove(size_t idx) {
             if (has_value(idx)) {
                 (_data + idx)->~elemType();
-                _used[idx] = false;
+                set_used(idx, false);
             }
         }
 
@@ -131,19 +795,73 @@ namespace s7a9 {
             remove(src);
         }
 
+        // destroy the values in slots [first, last)
+        void remove_range(size_t first, size_t last) {
+            if (first >= last) return;
+            if (!std::is_trivially_destructible<elemType>::value) {
+                _for_each_used(first, last, [this](size_t i) {
+                    (_data + i)->~elemType();
+                });
+            }
+            _set_bits(first, last, false);
+        }
+
+        // relocate the n used slots starting at src to dst; the ranges may overlap,
+        // and slots of the destination outside the source must be empty
+        void move_range(size_t dst, size_t src, size_t n) {
+            if (n == 0 || dst == src) return;
+            if constexpr (TRIVIAL) {
+                memmove(_data + dst, _data + src, n * sizeof(elemType));
+                _set_bits(src, src + n, false);
+                _set_bits(dst, dst + n, true);
+            }
+            else if (dst > src) {
+                for (size_t i = n; i > 0; --i)
+                    move_elem(dst + i - 1, src + i - 1);
+            }
+            else {
+                for (size_t i = 0; i < n; ++i)
+                    move_elem(dst + i, src + i);
+            }
+        }
+
         inline void construct(size_t idx, const elemType& value) {
             new(_data + idx) elemType(value);
-            _used[idx] = true;
+            set_used(idx, true);
         }
 
         inline void construct(size_t idx, elemType&& value) {
-            new(_data + idx) elemType(value);
-            _used[idx] = true;
+            new(_data + idx) elemType(Move(value));
+            set_used(idx, true);
+        }
+
+        // construct a value in slot idx from args
+        template <class... Args>
+        inline void emplace(size_t idx, Args&&... args) {
+            new(_data + idx) elemType(Forward<Args>(args)...);
+            set_used(idx, true);
+        }
+
+        // copy n values from first into the empty slots starting at idx, with one
+        // memcpy() when first points to trivially copyable elements; if a copy
+        // throws, the slots constructed so far stay marked as used
+        template <class It>
+        void construct_range(size_t idx, It first, size_t n) {
+            if constexpr (TRIVIAL && std::is_pointer<It>::value &&
+                std::is_same<std::remove_cv_t<std::remove_pointer_t<It>>, elemType>::value) {
+                if (n) memcpy(_data + idx, first, n * sizeof(elemType));
+                _set_bits(idx, idx + n, true);
+            }
+            else {
+                for (size_t i = idx; i < idx + n; ++i, ++first)
+                    construct(i, *first);
+            }
         }
 
         inline void clean() {
-            for (size_t i = 0; i < _num; ++i)
-                remove(i);
+            _destroy_all();
+            for (size_t w = 0; w < _word_num(_num); ++w)
+                _used[w] = 0;
         }
 
         inline elemType* data(size_t idx) noexcept {
@@ -167,18 +885,94 @@ namespace s7a9 {
         }
 
         inline bool has_value(size_t idx) const noexcept {
-            return _used[idx];
+            return (_used[idx / WORD_BITS] >> idx % WORD_BITS) & 1;
         }
 
         inline void set_used(size_t idx, bool val) noexcept {
-            _used[idx] = val;
+            if (val) _used[idx / WORD_BITS] |= word_t(1) << idx % WORD_BITS;
+            else _used[idx / WORD_BITS] &= ~(word_t(1) << idx % WORD_BITS);
         }
 
-        inline void swap(__malloc_allocator& other) noexcept {
-            s7a9::swap(_data, other._data);
-            s7a9::swap(_used, other._used);
-            s7a9::swap(_num, other._num);
+        // number of slots holding a value
+        size_t count() const noexcept {
+            size_t ret = 0;
+            for (size_t w = 0; w < _word_num(_num); ++w)
+                ret += popcount64(_used[w]);
+            return ret;
+        }
+
+        // first used slot not before idx, or length() if there is none
+        size_t next_used(size_t idx) const noexcept {
+            if (idx >= _num) return _num;
+            size_t w = idx / WORD_BITS;
+            word_t bits = _used[w] & (~word_t(0) << idx % WORD_BITS);
+            while (bits == 0) {
+                if (++w >= _word_num(_num)) return _num;
+                bits = _used[w];
+            }
+            return val_min(w * WORD_BITS + ctz64(bits), _num);
         }
+
+        inline void swap(__slot_allocator& other) {
+            if constexpr (INLINE) {
+                if (this == &other) return;
+                __slot_allocator tmp(Move(other));
+                other._reset();
+                other._take(*this);
+                _reset();
+                _take(tmp);
+            }
+            else {
+                s7a9::swap(_data, other._data);
+                s7a9::swap(_used, other._used);
+                s7a9::swap(_num, other._num);
+                _mem.swap(other._mem);
+                STLITE_STATS(_counter.swap(other._counter);)
+            }
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
+        }
+#endif
+    };
+
+    template <class elemType>
+    using __malloc_allocator = __slot_allocator<elemType, __malloc_memory>;
+
+    // Slot allocator whose blocks come from a private monotonic arena
+    // Growth never frees the old block, and all memory is dropped in one go
+    // when the allocator dies, e.g. for vectors built and discarded per request.
+    template <class elemType>
+    using __arena_allocator = __slot_allocator<elemType, __arena_memory>;
+
+#ifdef __linux__
+    // Slot allocator for very large buffers, see __mmap_memory
+    template <class elemType>
+    using __mmap_allocator = __slot_allocator<elemType, __mmap_memory>;
+#endif
+
+    // Slot allocator keeping up to N slots inside the object, see __inline_memory
+    template <class elemType, size_t N>
+    using __small_allocator = __slot_allocator<elemType,
+        __inline_memory<N * sizeof(elemType), (N + 63) / 64 * sizeof(unsigned long long)>>;
+
+    // Slot allocator for SIMD data, see __aligned_memory
+    template <class elemType, size_t Align = 64, bool Padded = false>
+    using __aligned_allocator = __slot_allocator<elemType, __aligned_memory<Align, Padded>>;
+
+    // The same kind of slot allocator for elements of type U
+    // Slot allocators keep their memory policy; anything else falls back to
+    // __malloc_allocator<U>.
+    template <class Allocator, class U>
+    struct __rebind_allocator {
+        typedef __malloc_allocator<U> type;
+    };
+
+    template <class elemType, class Memory, class U>
+    struct __rebind_allocator<__slot_allocator<elemType, Memory>, U> {
+        typedef __slot_allocator<U, Memory> type;
     };
 
     // Basic allocator
@@ -189,22 +983,32 @@ namespace s7a9 {
 
         size_t _num; // Total size
 
+        STLITE_STATS(__stats_counter _counter{ "new_allocator" };)
+
     public:
+        static constexpr bool CONTIGUOUS = false; // Every slot is a separate heap block
+
         // use new to allocate a pointer table
         explicit __new_allocator(const size_t num) noexcept :
             _num(num) {
             _data = new elemType * [num];
+            STLITE_STATS(_counter.on_alloc(num * sizeof(elemType*));)
             for (size_t i = 0; i < num; ++i) {
                 _data[i] = nullptr;
             }
         }
 
+        // empty allocator of num slots, nothing is shared with proto
+        __new_allocator(const size_t num, const __new_allocator&) noexcept :
+            __new_allocator(num) {}
+
         // copy constructor
         __new_allocator(const __new_allocator& x) : 
             _num(x._num) {
             _data = new elemType * [_num];
+            STLITE_STATS(_counter.on_alloc(_num * sizeof(elemType*));)
             for (size_t i = 0; i < _num; ++i) {
-                if (x[i]) _data[i] = new elemType(*x[i]);
+                if (x[i]) construct(i, *x[i]);
                 else _data[i] = nullptr;
             }
         }
@@ -215,11 +1019,13 @@ namespace s7a9 {
             _data = x._data;
             x._data = nullptr;
             x._num = 0;
+            STLITE_STATS(_counter.swap(x._counter);)
         }
 
         // free all memory when being deconstructed
         ~__new_allocator() {
             clean();
+            STLITE_STATS(if (_data) _counter.on_free(_num * sizeof(elemType*));)
             delete[] _data;
         }
 
@@ -234,8 +1040,11 @@ namespace s7a9 {
                 new_data[i] = nullptr;
             }
             for (; i < _num; ++i) {
-                delete _data[i];
+                remove(i);
             }
+            STLITE_STATS(_counter.on_alloc(num * sizeof(elemType*));)
+            STLITE_STATS(_counter.on_free(_num * sizeof(elemType*));)
+            STLITE_STATS(_counter.on_relocate(val_min(_num, num) * sizeof(elemType*));)
             delete[] _data;
             _num = num;
             return *(_data = new_data);
@@ -244,16 +1053,19 @@ namespace s7a9 {
         void copy(const __new_allocator& x) {
             if (this == &x) return;
             clean();
+            STLITE_STATS(if (_data) _counter.on_free(_num * sizeof(elemType*));)
             delete[] _data;
             _num = x._num;
             _data = new elemType * [_num];
+            STLITE_STATS(_counter.on_alloc(_num * sizeof(elemType*));)
             for (size_t i = 0; i < _num; ++i) {
-                if (x[i]) _data[i] = new elemType(*x[i]);
+                if (x[i]) construct(i, *x[i]);
                 else _data[i] = nullptr;
             }
         }
 
         inline void remove(size_t idx) {
+            STLITE_STATS(if (_data[idx]) _counter.on_free(sizeof(elemType));)
             delete _data[idx];
             _data[idx] = nullptr;
         }
@@ -263,12 +1075,31 @@ namespace s7a9 {
             _data[src] = nullptr;
         }
 
+        // relocate the n slots starting at src to dst; only pointers are moved
+        void move_range(size_t dst, size_t src, size_t n) noexcept {
+            if (n == 0 || dst == src) return;
+            memmove(_data + dst, _data + src, n * sizeof(elemType*));
+            size_t first = dst > src ? src : val_max(src, dst + n),
+                last = dst > src ? val_min(src + n, dst) : src + n;
+            for (size_t i = first; i < last; ++i)
+                _data[i] = nullptr;
+        }
+
         inline void construct(size_t idx, const elemType& value) {
             _data[idx] = new elemType(value);
+            STLITE_STATS(_counter.on_alloc(sizeof(elemType));)
         }
 
         inline void construct(size_t idx, elemType&& value) {
-            _data[idx] = new elemType(value);
+            _data[idx] = new elemType(Move(value));
+            STLITE_STATS(_counter.on_alloc(sizeof(elemType));)
+        }
+
+        // construct a value in slot idx from args
+        template <class... Args>
+        inline void emplace(size_t idx, Args&&... args) {
+            _data[idx] = new elemType(Forward<Args>(args)...);
+            STLITE_STATS(_counter.on_alloc(sizeof(elemType));)
         }
 
         inline void clean() {
@@ -308,8 +1139,267 @@ namespace s7a9 {
         inline void swap(__new_allocator& other) noexcept {
             s7a9::swap(_data, other._data);
             s7a9::swap(_num, other._num);
+            STLITE_STATS(_counter.swap(other._counter);)
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
+        }
+#endif
+    };
+
+    // Node allocator: hands out storage for one node at a time with operator new
+    template <class nodeType>
+    class __new_node_allocator {
+    private:
+        STLITE_STATS(__stats_counter _counter{ "new_node_allocator" };)
+
+    public:
+        __new_node_allocator() noexcept = default;
+
+        // nodes are never shared between containers, so a copy starts empty
+        __new_node_allocator(const __new_node_allocator&) noexcept {}
+
+        __new_node_allocator(__new_node_allocator&& x) noexcept {
+            STLITE_STATS(_counter.swap(x._counter);)
+        }
+
+        inline nodeType* allocate() {
+            void* p = ::operator new(sizeof(nodeType));
+            STLITE_STATS(_counter.on_alloc(sizeof(nodeType));)
+            return static_cast<nodeType*>(p);
+        }
+
+        inline void deallocate(nodeType* p) noexcept {
+            STLITE_STATS(_counter.on_free(sizeof(nodeType));)
+            ::operator delete(p);
+        }
+
+        // every node has been deallocated one by one, nothing left to do
+        inline void release() noexcept {}
+
+        // take over the nodes of other (they are independent heap blocks)
+        inline void merge(__new_node_allocator& other) noexcept {
+            STLITE_STATS(if (this != &other) _counter.merge(other._counter);)
+        }
+
+        inline void swap(__new_node_allocator& other) noexcept {
+            STLITE_STATS(_counter.swap(other._counter);)
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
         }
+#endif
     };
+
+    // Node allocator: size-class slab pool
+    // Node sizes are rounded up to a multiple of SIZE_CLASS and carved out of
+    // slabs that grow geometrically from MIN_SLAB to MAX_SLAB nodes. Freed nodes
+    // go to an intrusive free list, and release() returns all slabs at once.
+    template <class nodeType>
+    class __pool_allocator {
+    public:
+        // release() frees all nodes, so trivially destructible ones need no teardown walk
+        static constexpr bool SKIP_DESTROY = true;
+
+    private:
+        static constexpr size_t SIZE_CLASS = 16, MIN_SLAB = 8, MAX_SLAB = 4096;
+
+        static constexpr size_t SLOT_SIZE =
+            (sizeof(nodeType) + SIZE_CLASS - 1) / SIZE_CLASS * SIZE_CLASS;
+
+        static_assert(alignof(nodeType) <= SIZE_CLASS,
+            "__pool_allocator: node alignment exceeds the size class");
+
+        struct slot_t {
+            slot_t* next;
+        };
+
+        struct slab_t {
+            slab_t* next;
+        };
+
+        static constexpr size_t SLAB_HEADER =
+            (sizeof(slab_t) + SIZE_CLASS - 1) / SIZE_CLASS * SIZE_CLASS;
+
+        slab_t* _slabs; // All slabs owned by this pool
+
+        slot_t* _free; // Recycled nodes
+
+        char* _cur, * _lim; // Untouched part of the newest slab
+
+        size_t _slab_num; // Node count of the next slab
+
+        STLITE_STATS(__stats_counter _counter{ "pool_allocator" };)
+
+        void _new_slab() {
+            slab_t* slab = static_cast<slab_t*>(malloc(SLAB_HEADER + _slab_num * SLOT_SIZE));
+            if (slab == nullptr) throw std::bad_alloc();
+            slab->next = _slabs, _slabs = slab;
+            _cur = reinterpret_cast<char*>(slab) + SLAB_HEADER;
+            _lim = _cur + _slab_num * SLOT_SIZE;
+            if (_slab_num < MAX_SLAB) _slab_num *= 2;
+        }
+
+    public:
+        __pool_allocator() noexcept :
+            _slabs(nullptr), _free(nullptr), _cur(nullptr), _lim(nullptr), _slab_num(MIN_SLAB) {}
+
+        // nodes are never shared between containers, so a copy starts empty
+        __pool_allocator(const __pool_allocator&) noexcept :
+            __pool_allocator() {}
+
+        __pool_allocator(__pool_allocator&& x) noexcept :
+            _slabs(x._slabs), _free(x._free), _cur(x._cur), _lim(x._lim), _slab_num(x._slab_num) {
+            x._slabs = nullptr, x._free = nullptr;
+            x._cur = x._lim = nullptr;
+            x._slab_num = MIN_SLAB;
+            STLITE_STATS(_counter.swap(x._counter);)
+        }
+
+        ~__pool_allocator() {
+            release();
+        }
+
+        inline nodeType* allocate() {
+            STLITE_STATS(_counter.on_alloc(sizeof(nodeType));)
+            if (_free) {
+                slot_t* slot = _free;
+                _free = slot->next;
+                return reinterpret_cast<nodeType*>(slot);
+            }
+            if (_cur == _lim) _new_slab();
+            nodeType* ret = reinterpret_cast<nodeType*>(_cur);
+            _cur += SLOT_SIZE;
+            return ret;
+        }
+
+        inline void deallocate(nodeType* p) noexcept {
+            STLITE_STATS(_counter.on_free(sizeof(nodeType));)
+            slot_t* slot = reinterpret_cast<slot_t*>(p);
+            slot->next = _free, _free = slot;
+        }
+
+        // free every slab; all nodes must have been destroyed before
+        void release() noexcept {
+            while (_slabs) {
+                slab_t* nxt = _slabs->next;
+                free(_slabs);
+                _slabs = nxt;
+            }
+            _free = nullptr;
+            _cur = _lim = nullptr;
+            _slab_num = MIN_SLAB;
+            STLITE_STATS(_counter.on_release();)
+        }
+
+        // take over the slabs of other, used when nodes are spliced between containers
+        void merge(__pool_allocator& other) noexcept {
+            if (this == &other) return;
+            if (other._slabs) {
+                slab_t* tail = other._slabs;
+                while (tail->next) tail = tail->next;
+                tail->next = _slabs, _slabs = other._slabs;
+            }
+            if (other._free) {
+                slot_t* tail = other._free;
+                while (tail->next) tail = tail->next;
+                tail->next = _free, _free = other._free;
+            }
+            other._slabs = nullptr, other._free = nullptr;
+            other._cur = other._lim = nullptr;
+            other._slab_num = MIN_SLAB;
+            STLITE_STATS(_counter.merge(other._counter);)
+        }
+
+        inline void swap(__pool_allocator& other) noexcept {
+            s7a9::swap(_slabs, other._slabs);
+            s7a9::swap(_free, other._free);
+            s7a9::swap(_cur, other._cur);
+            s7a9::swap(_lim, other._lim);
+            s7a9::swap(_slab_num, other._slab_num);
+            STLITE_STATS(_counter.swap(other._counter);)
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
+        }
+#endif
+    };
+
+    // Node allocator: private monotonic arena
+    // deallocate() is a no-op and release() drops all nodes at once. With
+    // SkipDestroy, containers holding trivially destructible nodes skip walking
+    // them on clear() and destruction.
+    template <class nodeType, bool SkipDestroy = true>
+    class __arena_node_allocator {
+    private:
+        __monotonic_arena _arena;
+
+        STLITE_STATS(__stats_counter _counter{ "arena_node_allocator" };)
+
+    public:
+        static constexpr bool SKIP_DESTROY = SkipDestroy;
+
+        __arena_node_allocator() noexcept = default;
+
+        // nodes are never shared between containers, so a copy starts empty
+        __arena_node_allocator(const __arena_node_allocator&) noexcept {}
+
+        __arena_node_allocator(__arena_node_allocator&& x) noexcept :
+            _arena(Move(x._arena)) {
+            STLITE_STATS(_counter.swap(x._counter);)
+        }
+
+        inline nodeType* allocate() {
+            void* p = _arena.allocate(sizeof(nodeType), alignof(nodeType));
+            if (p == nullptr) throw std::bad_alloc();
+            STLITE_STATS(_counter.on_alloc(sizeof(nodeType));)
+            return static_cast<nodeType*>(p);
+        }
+
+        // the node stays in the arena until release(); it is counted as freed
+        inline void deallocate(nodeType*) noexcept {
+            STLITE_STATS(_counter.on_free(sizeof(nodeType));)
+        }
+
+        inline void release() noexcept {
+            _arena.release();
+            STLITE_STATS(_counter.on_release();)
+        }
+
+        // take over the chunks of other, used when nodes are spliced between containers
+        inline void merge(__arena_node_allocator& other) noexcept {
+            _arena.merge(other._arena);
+            STLITE_STATS(if (this != &other) _counter.merge(other._counter);)
+        }
+
+        inline void swap(__arena_node_allocator& other) noexcept {
+            _arena.swap(other._arena);
+            STLITE_STATS(_counter.swap(other._counter);)
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
+        }
+#endif
+    };
+
+    // Whether a container may skip destroying its nodes one by one before
+    // calling release(): the allocator must declare SKIP_DESTROY and the node
+    // must be trivially destructible.
+    template <class NodeAllocator, class nodeType, class = void>
+    struct __skip_destroy : std::false_type {};
+
+    template <class NodeAllocator, class nodeType>
+    struct __skip_destroy<NodeAllocator, nodeType, std::void_t<decltype(NodeAllocator::SKIP_DESTROY)>> :
+        std::integral_constant<bool,
+            NodeAllocator::SKIP_DESTROY && std::is_trivially_destructible<nodeType>::value> {};
 }
 
 #endif // STLITE_ALLOCATOR_HPP
\ No newline at end of file
@@ -0,0 +1,282 @@
+#ifndef STLITE_ALLOCATOR_STATS_HPP
+#define STLITE_ALLOCATOR_STATS_HPP
+
+#include <cstddef>
+#include "utilities.hpp"
+
+// Define STLITE_ALLOCATOR_STATS_ENABLED before including any container to make
+// every allocator count its traffic and to get the stats() members. Without it
+// the counters and every update compile away.
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#define STLITE_STATS(stmt) stmt
+#else
+#define STLITE_STATS(stmt)
+#endif
+
+namespace s7a9 {
+    // Snapshot of the counters of one allocator, or a sum of several
+    struct alloc_stats {
+        size_t allocs = 0, frees = 0, reallocs = 0;
+
+        size_t bytes_live = 0, bytes_peak = 0;
+
+        size_t bytes_moved = 0; // Bytes relocated while growing or shrinking
+
+        alloc_stats& operator+=(const alloc_stats& x) noexcept {
+            allocs += x.allocs, frees += x.frees, reallocs += x.reallocs;
+            bytes_live += x.bytes_live, bytes_peak += x.bytes_peak;
+            bytes_moved += x.bytes_moved;
+            return *this;
+        }
+    };
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+    class __stats_counter;
+
+    // Process-wide registry of all counters, grouped by allocator label
+    // Counters of destroyed allocators are folded into per-label totals.
+    class alloc_stats_registry {
+    private:
+        friend __stats_counter;
+
+        static constexpr size_t MAX_LABELS = 32;
+
+        struct label_t {
+            const char* name;
+            alloc_stats retired;
+            size_t peak; // Highest peak of a single allocator
+        };
+
+        std::mutex _lock;
+
+        __stats_counter* _head;
+
+        label_t _labels[MAX_LABELS];
+
+        size_t _label_num;
+
+        std::atomic<size_t> _bytes_live, _bytes_peak;
+
+        alloc_stats_registry() noexcept :
+            _head(nullptr), _label_num(0), _bytes_live(0), _bytes_peak(0) {}
+
+        // must hold _lock
+        label_t* _label(const char* name) noexcept {
+            for (size_t i = 0; i < _label_num; ++i)
+                if (strcmp(_labels[i].name, name) == 0) return _labels + i;
+            if (_label_num == MAX_LABELS) return nullptr;
+            _labels[_label_num] = label_t{ name, alloc_stats(), 0 };
+            return _labels + _label_num++;
+        }
+
+        inline void _add_live(size_t bytes) noexcept {
+            size_t live = _bytes_live.fetch_add(bytes, std::memory_order_relaxed) + bytes,
+                peak = _bytes_peak.load(std::memory_order_relaxed);
+            while (live > peak && !_bytes_peak.compare_exchange_weak(peak, live,
+                std::memory_order_relaxed));
+        }
+
+        inline void _sub_live(size_t bytes) noexcept {
+            _bytes_live.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        void _attach(__stats_counter* counter);
+
+        void _detach(__stats_counter* counter);
+
+    public:
+        static alloc_stats_registry& instance() {
+            static alloc_stats_registry* registry = new alloc_stats_registry();
+            return *registry;
+        }
+
+        // bytes currently held by all allocators
+        size_t bytes_live() const noexcept {
+            return _bytes_live.load(std::memory_order_relaxed);
+        }
+
+        // the highest bytes_live() seen so far
+        size_t bytes_peak() const noexcept {
+            return _bytes_peak.load(std::memory_order_relaxed);
+        }
+
+        // sum over all allocators with this label, live or destroyed; safe
+        // while other threads use their containers, though the counts of an
+        // allocator in use may be read at slightly different moments
+        alloc_stats total(const char* name);
+
+        // print one line per label and the process-wide totals, as total() reads them
+        void dump(FILE* out = stderr);
+    };
+
+    // Counter embedded in an allocator
+    // A copy starts from zero; moving or swapping carries the counts along.
+    // Only the owning allocator writes the fields, with relaxed atomic loads
+    // and stores, so the registry may read them from any thread.
+    class __stats_counter {
+    private:
+        friend alloc_stats_registry;
+
+        const char* _label;
+
+        std::atomic<size_t> _allocs{ 0 }, _frees{ 0 }, _reallocs{ 0 };
+
+        std::atomic<size_t> _bytes_live{ 0 }, _bytes_peak{ 0 }, _bytes_moved{ 0 };
+
+        __stats_counter* _prev, * _next;
+
+        static inline size_t _get(const std::atomic<size_t>& x) noexcept {
+            return x.load(std::memory_order_relaxed);
+        }
+
+        static inline void _set(std::atomic<size_t>& x, size_t val) noexcept {
+            x.store(val, std::memory_order_relaxed);
+        }
+
+        // a plain read-modify-write is enough with a single writer
+        static inline void _add(std::atomic<size_t>& x, size_t n) noexcept {
+            _set(x, _get(x) + n);
+        }
+
+        void _assign(const alloc_stats& x) noexcept {
+            _set(_allocs, x.allocs), _set(_frees, x.frees), _set(_reallocs, x.reallocs);
+            _set(_bytes_live, x.bytes_live), _set(_bytes_peak, x.bytes_peak);
+            _set(_bytes_moved, x.bytes_moved);
+        }
+
+    public:
+        explicit __stats_counter(const char* label) :
+            _label(label) {
+            alloc_stats_registry::instance()._attach(this);
+        }
+
+        __stats_counter(const __stats_counter& x) :
+            __stats_counter(x._label) {}
+
+        // the registry links belong to this object
+        __stats_counter& operator=(const __stats_counter&) = delete;
+
+        ~__stats_counter() {
+            alloc_stats_registry::instance()._detach(this);
+        }
+
+        // snapshot of the fields, each read on its own
+        alloc_stats stats() const noexcept {
+            alloc_stats ret;
+            ret.allocs = _get(_allocs), ret.frees = _get(_frees), ret.reallocs = _get(_reallocs);
+            ret.bytes_live = _get(_bytes_live), ret.bytes_peak = _get(_bytes_peak);
+            ret.bytes_moved = _get(_bytes_moved);
+            return ret;
+        }
+
+        inline void on_alloc(size_t bytes) noexcept {
+            _add(_allocs, 1);
+            on_resize(0, bytes);
+        }
+
+        inline void on_free(size_t bytes) noexcept {
+            _add(_frees, 1);
+            on_resize(bytes, 0);
+        }
+
+        // a block changed size from old_bytes to bytes
+        inline void on_resize(size_t old_bytes, size_t bytes) noexcept {
+            size_t live = _get(_bytes_live) + (bytes - old_bytes);
+            _set(_bytes_live, live);
+            if (live > _get(_bytes_peak)) _set(_bytes_peak, live);
+            if (bytes > old_bytes) alloc_stats_registry::instance()._add_live(bytes - old_bytes);
+            else alloc_stats_registry::instance()._sub_live(old_bytes - bytes);
+        }
+
+        // one reallocation that had to move `moved` bytes of live data
+        inline void on_relocate(size_t moved) noexcept {
+            _add(_reallocs, 1);
+            _add(_bytes_moved, moved);
+        }
+
+        // everything still allocated was dropped at once
+        inline void on_release() noexcept {
+            alloc_stats_registry::instance()._sub_live(_get(_bytes_live));
+            _set(_frees, _get(_allocs));
+            _set(_bytes_live, 0);
+        }
+
+        // take over the counts of other, whose blocks now belong to this allocator
+        void merge(__stats_counter& other) noexcept {
+            alloc_stats sum = stats();
+            sum += other.stats();
+            if (sum.bytes_live > sum.bytes_peak) sum.bytes_peak = sum.bytes_live;
+            _assign(sum);
+            other._assign(alloc_stats());
+        }
+
+        inline void swap(__stats_counter& other) noexcept {
+            alloc_stats tmp = stats();
+            _assign(other.stats());
+            other._assign(tmp);
+        }
+    };
+
+    inline void alloc_stats_registry::_attach(__stats_counter* counter) {
+        std::lock_guard<std::mutex> guard(_lock);
+        counter->_prev = nullptr, counter->_next = _head;
+        if (_head) _head->_prev = counter;
+        _head = counter;
+    }
+
+    inline void alloc_stats_registry::_detach(__stats_counter* counter) {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (counter->_prev) counter->_prev->_next = counter->_next;
+        else _head = counter->_next;
+        if (counter->_next) counter->_next->_prev = counter->_prev;
+        alloc_stats dead = counter->stats();
+        _sub_live(dead.bytes_live);
+        label_t* label = _label(counter->_label);
+        if (label == nullptr) return;
+        dead.bytes_live = 0;
+        if (dead.bytes_peak > label->peak) label->peak = dead.bytes_peak;
+        dead.bytes_peak = 0;
+        label->retired += dead;
+    }
+
+    inline alloc_stats alloc_stats_registry::total(const char* name) {
+        std::lock_guard<std::mutex> guard(_lock);
+        alloc_stats ret;
+        label_t* label = _label(name);
+        if (label) ret = label->retired, ret.bytes_peak = label->peak;
+        for (__stats_counter* c = _head; c; c = c->_next) {
+            if (strcmp(c->_label, name) != 0) continue;
+            alloc_stats s = c->stats();
+            size_t peak = val_max(ret.bytes_peak, s.bytes_peak);
+            ret += s;
+            ret.bytes_peak = peak;
+        }
+        return ret;
+    }
+
+    inline void alloc_stats_registry::dump(FILE* out) {
+        const char* names[MAX_LABELS];
+        size_t name_num;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            for (__stats_counter* c = _head; c; c = c->_next) _label(c->_label);
+            name_num = _label_num;
+            for (size_t i = 0; i < name_num; ++i) names[i] = _labels[i].name;
+        }
+        fprintf(out, "%-24s %12s %12s %12s %14s %14s %14s\n", "allocator",
+            "allocs", "frees", "reallocs", "bytes_live", "bytes_peak", "bytes_moved");
+        for (size_t i = 0; i < name_num; ++i) {
+            alloc_stats s = total(names[i]);
+            fprintf(out, "%-24s %12zu %12zu %12zu %14zu %14zu %14zu\n", names[i],
+                s.allocs, s.frees, s.reallocs, s.bytes_live, s.bytes_peak, s.bytes_moved);
+        }
+        fprintf(out, "process: %zu bytes live, %zu bytes peak\n", bytes_live(), bytes_peak());
+    }
+#endif
+}
+
+#endif // STLITE_ALLOCATOR_STATS_HPP
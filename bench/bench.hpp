@@ -0,0 +1,52 @@
+#ifndef STLITE_BENCH_HPP
+#define STLITE_BENCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace bench {
+    typedef std::chrono::steady_clock clock_type;
+
+    inline double seconds_since(clock_type::time_point start) {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    // argv[idx] as an integer, or def if it is missing
+    inline long arg(int argc, char** argv, int idx, long def) {
+        return argc > idx ? atol(argv[idx]) : def;
+    }
+
+    // 1, 2, 4, ... up to hi, with hi itself last
+    inline std::vector<int> thread_counts(int lo, int hi) {
+        std::vector<int> ret;
+        for (int n = lo; n < hi; n *= 2) ret.push_back(n);
+        ret.push_back(hi);
+        return ret;
+    }
+
+    // run func(i) on n threads released at the same moment, and return the
+    // seconds until the last one finished
+    template <class Func>
+    double run_threads(int n, Func func) {
+        std::atomic<int> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < n; ++i)
+            threads.emplace_back([&, i]() {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                func(i);
+            });
+        while (ready.load() != n) std::this_thread::yield();
+        clock_type::time_point start = clock_type::now();
+        go.store(true, std::memory_order_release);
+        for (auto& t : threads) t.join();
+        return seconds_since(start);
+    }
+}
+
+#endif // STLITE_BENCH_HPP
@@ -0,0 +1,43 @@
+// Parallel push_back into one shared array from 1 to max_threads threads:
+// s7a9::vector behind a std::mutex against concurrent_vector.
+//   usage: concurrent_vector [max_threads] [pushes_per_thread]
+#include <mutex>
+#include "../concurrent_vector.hpp"
+#include "../vector.hpp"
+#include "bench.hpp"
+
+namespace {
+    double locked(int threads, long pushes) {
+        s7a9::vector<long> v;
+        std::mutex mutex;
+        return bench::run_threads(threads, [&](int t) {
+            for (long i = 0; i < pushes; ++i) {
+                std::lock_guard<std::mutex> lock(mutex);
+                v.push_back(t * pushes + i);
+            }
+        });
+    }
+
+    double lock_free(int threads, long pushes) {
+        s7a9::concurrent_vector<long> v;
+        return bench::run_threads(threads, [&](int t) {
+            for (long i = 0; i < pushes; ++i)
+                v.push_back(t * pushes + i);
+        });
+    }
+
+    void report(const char* name, int threads, long pushes, double sec) {
+        printf("%-18s threads=%-3d %8.3f s %10.2f Mpush/s\n", name, threads, sec,
+            double(threads) * pushes / sec / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    int max_threads = bench::arg(argc, argv, 1, 64);
+    long pushes = bench::arg(argc, argv, 2, 250000);
+    for (int n : bench::thread_counts(1, max_threads)) {
+        report("mutex+vector", n, pushes, locked(n, pushes));
+        report("concurrent_vector", n, pushes, lock_free(n, pushes));
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Many producers and many consumers sharing one bounded queue, from 2 to
+// max_threads threads split evenly between the two sides: mpmc_queue with
+// blocking push/pop and with try_push/try_pop, against s7a9::deque behind
+// a std::mutex.
+//   usage: mpmc_queue [max_threads] [items_per_producer]
+#include <mutex>
+#include "../deque.hpp"
+#include "../mpmc_queue.hpp"
+#include "bench.hpp"
+
+namespace {
+    const size_t CAPACITY = 1024;
+
+    // s7a9::deque behind a mutex, bounded to CAPACITY
+    class locked_deque {
+    private:
+        std::mutex _mutex;
+
+        s7a9::deque<long> _deque;
+
+    public:
+        bool try_push(long x) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_deque.size() == CAPACITY) return false;
+            _deque.push_back(x);
+            return true;
+        }
+
+        bool try_pop(long& x) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_deque.empty()) return false;
+            x = _deque.front();
+            _deque.pop_front();
+            return true;
+        }
+    };
+
+    struct mpmc : s7a9::mpmc_queue<long> {
+        mpmc() : s7a9::mpmc_queue<long>(CAPACITY) {}
+    };
+
+    // threads / 2 producers each push items, threads / 2 consumers each pop
+    // as many; Blocking picks push()/pop() over spinning on try_push()/try_pop()
+    template <class Queue, bool Blocking>
+    double contend(int threads, long items) {
+        Queue q;
+        int pairs = threads / 2;
+        std::atomic<long> sum(0);
+        double sec = bench::run_threads(pairs * 2, [&](int t) {
+            if (t < pairs) {
+                for (long i = 0; i < items; ++i) {
+                    if constexpr (Blocking) q.push(i);
+                    else while (!q.try_push(i)) std::this_thread::yield();
+                }
+            }
+            else {
+                long x, local = 0;
+                for (long i = 0; i < items; ++i) {
+                    if constexpr (Blocking) q.pop(x);
+                    else while (!q.try_pop(x)) std::this_thread::yield();
+                    local += x;
+                }
+                sum.fetch_add(local);
+            }
+        });
+        if (sum.load() != pairs * (items * (items - 1) / 2)) puts("contend: lost elements");
+        return sec;
+    }
+
+    void report(const char* name, int threads, long items, double sec) {
+        printf("%-20s threads=%-3d %8.3f s %10.2f Mitems/s\n", name, threads, sec,
+            double(threads / 2) * items / sec / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    int max_threads = bench::arg(argc, argv, 1, 64);
+    long items = bench::arg(argc, argv, 2, 500000);
+    for (int n : bench::thread_counts(2, max_threads)) {
+        report("mutex+deque", n, items, contend<locked_deque, false>(n, items));
+        report("mpmc_queue try_", n, items, contend<mpmc, false>(n, items));
+        report("mpmc_queue blocking", n, items, contend<mpmc, true>(n, items));
+    }
+    return 0;
+}
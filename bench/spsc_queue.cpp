@@ -0,0 +1,118 @@
+// One producer and one consumer thread handing over longs: spsc_queue
+// (single and batched) against s7a9::deque behind a std::mutex. Throughput
+// streams count elements; latency bounces one element through a pair of
+// queues and reports the mean one-way time.
+//   usage: spsc_queue [count] [round_trips]
+#include <mutex>
+#include "../deque.hpp"
+#include "../spsc_queue.hpp"
+#include "bench.hpp"
+
+namespace {
+    const size_t CAPACITY = 4096, BATCH = 64;
+
+    // s7a9::deque behind a mutex with the try_push/try_pop interface
+    class locked_deque {
+    private:
+        std::mutex _mutex;
+
+        s7a9::deque<long> _deque;
+
+    public:
+        bool try_push(long x) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_deque.size() == CAPACITY) return false;
+            _deque.push_back(x);
+            return true;
+        }
+
+        bool try_pop(long& x) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_deque.empty()) return false;
+            x = _deque.front();
+            _deque.pop_front();
+            return true;
+        }
+    };
+
+    template <class Queue>
+    double throughput(long count) {
+        Queue q;
+        long sum = 0;
+        double sec = bench::run_threads(2, [&](int t) {
+            if (t == 0) {
+                for (long i = 0; i < count; ++i)
+                    while (!q.try_push(i)) std::this_thread::yield();
+            }
+            else {
+                long x;
+                for (long i = 0; i < count; ++i) {
+                    while (!q.try_pop(x)) std::this_thread::yield();
+                    sum += x;
+                }
+            }
+        });
+        if (sum != count * (count - 1) / 2) puts("throughput: lost elements");
+        return sec;
+    }
+
+    double throughput_batched(long count) {
+        s7a9::spsc_queue<long> q(CAPACITY);
+        long sum = 0;
+        double sec = bench::run_threads(2, [&](int t) {
+            long buf[BATCH];
+            if (t == 0) {
+                for (long i = 0; i < count;) {
+                    size_t n = count - i < long(BATCH) ? size_t(count - i) : BATCH;
+                    for (size_t k = 0; k < n; ++k) buf[k] = i + k;
+                    size_t done = q.try_push_n(buf, n);
+                    if (done == 0) std::this_thread::yield();
+                    i += done;
+                }
+            }
+            else {
+                for (long i = 0; i < count;) {
+                    size_t n = q.try_pop_n(buf, BATCH);
+                    if (n == 0) std::this_thread::yield();
+                    for (size_t k = 0; k < n; ++k) sum += buf[k];
+                    i += n;
+                }
+            }
+        });
+        if (sum != count * (count - 1) / 2) puts("throughput: lost elements");
+        return sec;
+    }
+
+    template <class Queue>
+    double latency(long trips) {
+        Queue ping, pong;
+        double sec = bench::run_threads(2, [&](int t) {
+            Queue& in = t ? ping : pong, & out = t ? pong : ping;
+            long x = 0;
+            for (long i = 0; i < trips; ++i) {
+                if (t == 0) while (!out.try_push(i)) std::this_thread::yield();
+                while (!in.try_pop(x)) std::this_thread::yield();
+                if (t == 1) while (!out.try_push(x)) std::this_thread::yield();
+            }
+        });
+        return sec / trips / 2;
+    }
+
+    struct spsc : s7a9::spsc_queue<long> {
+        spsc() : s7a9::spsc_queue<long>(CAPACITY) {}
+    };
+
+    void report(const char* name, long count, double sec) {
+        printf("%-22s %8.3f s %10.2f M/s\n", name, sec, count / sec / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    long count = bench::arg(argc, argv, 1, 20000000), trips = bench::arg(argc, argv, 2, 200000);
+    report("mutex+deque", count, throughput<locked_deque>(count));
+    report("spsc_queue", count, throughput<spsc>(count));
+    report("spsc_queue batched", count, throughput_batched(count));
+    printf("%-22s %8.0f ns one-way\n", "mutex+deque", latency<locked_deque>(trips) * 1e9);
+    printf("%-22s %8.0f ns one-way\n", "spsc_queue", latency<spsc>(trips) * 1e9);
+    return 0;
+}
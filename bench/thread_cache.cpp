@@ -0,0 +1,58 @@
+// Insert/erase churn on sjtu::map from 1 to N threads (default: one per
+// hardware thread), with the slab pool, plain new/delete and the per-thread
+// node cache. Every second map is handed to another thread to destroy, so
+// remote frees are part of the load.
+//   usage: thread_cache [max_threads] [rounds_per_thread]
+#include <mutex>
+#include "../map.hpp"
+#include "../thread_cache.hpp"
+#include "bench.hpp"
+
+namespace {
+    const int KEYS = 2000;
+
+    template <template <class> class NodeAllocator>
+    double churn(int threads, int rounds) {
+        typedef sjtu::map<int, long, std::less<int>, NodeAllocator> map_type;
+        std::mutex mutex;
+        std::vector<map_type*> handoff;
+        double sec = bench::run_threads(threads, [&](int t) {
+            for (int r = 0; r < rounds; ++r) {
+                map_type* m = new map_type;
+                for (int i = 0; i < KEYS; ++i) (*m)[(i * 7919 + t) % (KEYS * 5 / 2)] = i;
+                for (int i = 0; i < KEYS / 2; ++i) {
+                    auto it = m->find(i);
+                    if (it != m->end()) m->erase(it);
+                }
+                map_type* other = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (r % 2) handoff.push_back(m), m = nullptr;
+                    else if (!handoff.empty()) other = handoff.back(), handoff.pop_back();
+                }
+                delete m;
+                delete other;
+            }
+        });
+        for (map_type* m : handoff) delete m;
+        return sec;
+    }
+
+    template <template <class> class NodeAllocator>
+    void report(const char* name, int threads, int rounds) {
+        double sec = churn<NodeAllocator>(threads, rounds);
+        double ops = double(threads) * rounds * KEYS * 3 / 2;
+        printf("%-14s threads=%-3d %8.3f s %10.2f Mops/s\n", name, threads, sec, ops / sec / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    int hw = std::thread::hardware_concurrency();
+    int max_threads = bench::arg(argc, argv, 1, hw ? hw : 4), rounds = bench::arg(argc, argv, 2, 200);
+    for (int n : bench::thread_counts(1, max_threads)) {
+        report<s7a9::__pool_allocator>("pool", n, rounds);
+        report<s7a9::__new_node_allocator>("new/delete", n, rounds);
+        report<s7a9::__thread_cached_allocator>("thread_cache", n, rounds);
+    }
+    return 0;
+}
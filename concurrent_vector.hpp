@@ -0,0 +1,269 @@
+#ifndef STLITE_CONCURRENT_VECTOR_HPP
+#define STLITE_CONCURRENT_VECTOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include "allocator.hpp"
+#include "exceptions.hpp"
+
+namespace s7a9 {
+    // Lock-free append-only vector
+    // push_back() and grow_by() claim indices with a compare-and-swap and return
+    // them; the indices never change. Storage is segmented like stable_vector
+    // (segment k holds FirstSegment << k slots), and a missing segment is
+    // installed with a compare-and-swap by whichever thread needs it first,
+    // so growth never moves a published element. An element is published
+    // once its constructor has returned: get() and at() read published slots
+    // wait-free from any thread, and operator[] may be used for indices known
+    // to be published, e.g. the caller's own or all of them after joining the
+    // writers. size() counts claimed indices, published or not. clear(),
+    // assignment and destruction need exclusive access.
+    template <class elemType, size_t FirstSegment = 64>
+    class concurrent_vector {
+    private:
+        static_assert(FirstSegment > 0 && (FirstSegment & (FirstSegment - 1)) == 0,
+            "concurrent_vector: the first segment size must be a power of two");
+
+        static constexpr size_t FIRST_BITS = log2_floor(FirstSegment),
+            MAX_SEGMENTS = 63 - FIRST_BITS,
+            ALIGN = alignof(elemType) > alignof(std::max_align_t) ? alignof(elemType) : alignof(std::max_align_t);
+
+        // A segment of n slots: n ready flags, then the elements at FLAGS_BYTES(n)
+        typedef std::atomic<bool> flag_t;
+
+        std::atomic<char*> _segs[MAX_SEGMENTS];
+
+        cache_padded<std::atomic<size_t>> _size; // Claimed indices
+
+        static inline size_t _seg_size(size_t seg) noexcept {
+            return FirstSegment << seg;
+        }
+
+        static inline size_t _seg_start(size_t seg) noexcept {
+            return (FirstSegment << seg) - FirstSegment;
+        }
+
+        static inline size_t _seg_of(size_t idx) noexcept {
+            return 63 - clz64(idx + FirstSegment) - FIRST_BITS;
+        }
+
+        static inline size_t _flags_bytes(size_t n) noexcept {
+            return (n * sizeof(flag_t) + ALIGN - 1) / ALIGN * ALIGN;
+        }
+
+        static inline flag_t* _flags(char* seg) noexcept {
+            return reinterpret_cast<flag_t*>(seg);
+        }
+
+        static inline elemType* _elems(char* seg, size_t n) noexcept {
+            return reinterpret_cast<elemType*>(seg + _flags_bytes(n));
+        }
+
+        // segment seg, installing it first if no thread has
+        char* _segment(size_t seg) {
+            char* p = _segs[seg].load(std::memory_order_acquire);
+            if (p) return p;
+            size_t n = _seg_size(seg);
+            char* fresh = static_cast<char*>(::operator new(
+                _flags_bytes(n) + n * sizeof(elemType), std::align_val_t(ALIGN)));
+            for (size_t i = 0; i < n; ++i)
+                new(_flags(fresh) + i) flag_t(false);
+            if (_segs[seg].compare_exchange_strong(p, fresh,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+                return fresh;
+            _free_segment(fresh, n); // another thread won the race
+            return p;
+        }
+
+        static void _free_segment(char* seg, size_t n) noexcept {
+            for (size_t i = 0; i < n; ++i)
+                _flags(seg)[i].~flag_t();
+            ::operator delete(seg, std::align_val_t(ALIGN));
+        }
+
+        // claim n indices and make sure their segments exist; the bound is
+        // checked before the claim, so a failed one leaves size() alone
+        size_t _claim(size_t n) {
+            size_t first = _size->load(std::memory_order_relaxed);
+            do {
+                if (n > _seg_start(MAX_SEGMENTS) - first) throw sjtu::runtime_error();
+            } while (!_size->compare_exchange_weak(first, first + n, std::memory_order_relaxed));
+            if (n) {
+                for (size_t seg = _seg_of(first); seg <= _seg_of(first + n - 1); ++seg)
+                    _segment(seg);
+            }
+            return first;
+        }
+
+        // construct slot idx from args and publish it
+        template <class... Args>
+        inline elemType& _publish(size_t idx, Args&&... args) {
+            size_t seg = _seg_of(idx), off = idx - _seg_start(seg);
+            char* p = _segs[seg].load(std::memory_order_acquire);
+            elemType* elem = new(_elems(p, _seg_size(seg)) + off) elemType(Forward<Args>(args)...);
+            _flags(p)[off].store(true, std::memory_order_release);
+            return *elem;
+        }
+
+        // slot idx if it is published, otherwise nullptr
+        inline elemType* _get(size_t idx) const noexcept {
+            size_t seg = _seg_of(idx), off = idx - _seg_start(seg);
+            char* p = _segs[seg].load(std::memory_order_acquire);
+            if (p == nullptr || !_flags(p)[off].load(std::memory_order_acquire)) return nullptr;
+            return _elems(p, _seg_size(seg)) + off;
+        }
+
+        // copy the published elements of x to the same indices; slots x has
+        // claimed but not published stay unpublished here too
+        void _copy_from(const concurrent_vector& x) {
+            size_t n = x.size();
+            _claim(n);
+            for (size_t i = 0; i < n; ++i)
+                if (const elemType* p = x._get(i)) _publish(i, *p);
+        }
+
+        void _clean() noexcept {
+            for (size_t seg = 0; seg < MAX_SEGMENTS; ++seg) {
+                char* p = _segs[seg].load(std::memory_order_relaxed);
+                if (p == nullptr) continue;
+                size_t n = _seg_size(seg);
+                for (size_t i = 0; i < n; ++i)
+                    if (_flags(p)[i].load(std::memory_order_relaxed)) _elems(p, n)[i].~elemType();
+                _free_segment(p, n);
+                _segs[seg].store(nullptr, std::memory_order_relaxed);
+            }
+            _size->store(0, std::memory_order_relaxed);
+        }
+
+    public:
+        concurrent_vector() noexcept {
+            for (size_t seg = 0; seg < MAX_SEGMENTS; ++seg)
+                _segs[seg].store(nullptr, std::memory_order_relaxed);
+            _size->store(0, std::memory_order_relaxed);
+        }
+
+        // copy the published elements of x at their indices; x must not be growing
+        concurrent_vector(const concurrent_vector& x) :
+            concurrent_vector() {
+            _copy_from(x);
+        }
+
+        concurrent_vector& operator=(const concurrent_vector& rhs) {
+            if (this == &rhs) return *this;
+            _clean();
+            _copy_from(rhs);
+            return *this;
+        }
+
+        ~concurrent_vector() {
+            _clean();
+        }
+
+        // number of claimed indices, some of which may not be published yet
+        size_t size() const noexcept {
+            return _size->load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        // slots allocated so far
+        size_t capacity() const noexcept {
+            size_t seg = 0;
+            while (seg < MAX_SEGMENTS && _segs[seg].load(std::memory_order_acquire)) ++seg;
+            return _seg_start(seg);
+        }
+
+        // append x and return its index
+        size_t push_back(const elemType& x) {
+            size_t idx = _claim(1);
+            _publish(idx, x);
+            return idx;
+        }
+
+        size_t push_back(elemType&& x) {
+            size_t idx = _claim(1);
+            _publish(idx, Move(x));
+            return idx;
+        }
+
+        template <class... Args>
+        size_t emplace_back(Args&&... args) {
+            size_t idx = _claim(1);
+            _publish(idx, Forward<Args>(args)...);
+            return idx;
+        }
+
+        // append n copies of value and return the index of the first
+        size_t grow_by(size_t n, const elemType& value = elemType()) {
+            size_t first = _claim(n);
+            for (size_t i = first; i < first + n; ++i)
+                _publish(i, value);
+            return first;
+        }
+
+        // append copies of [first, last) and return the index of the first
+        template <class ForwardIt, class = std::enable_if_t<__is_iterator<ForwardIt, std::forward_iterator_tag>::value>>
+        size_t grow_by(ForwardIt first, ForwardIt last) {
+            size_t start = _claim(std::distance(first, last)), i = start;
+            for (; first != last; ++first)
+                _publish(i++, *first);
+            return start;
+        }
+
+        // whether element idx has been published
+        bool published(size_t idx) const noexcept {
+            return idx < size() && _get(idx) != nullptr;
+        }
+
+        // element idx, or nullptr if it is not published yet; wait-free
+        elemType* get(size_t idx) noexcept {
+            return idx < size() ? _get(idx) : nullptr;
+        }
+
+        const elemType* get(size_t idx) const noexcept {
+            return idx < size() ? _get(idx) : nullptr;
+        }
+
+        // element idx; throw if it is not published yet
+        elemType& at(size_t idx) {
+            elemType* p = get(idx);
+            if (p == nullptr) throw sjtu::index_out_of_bound();
+            return *p;
+        }
+
+        const elemType& at(size_t idx) const {
+            const elemType* p = get(idx);
+            if (p == nullptr) throw sjtu::index_out_of_bound();
+            return *p;
+        }
+
+        // element idx, which must be published
+        elemType& operator[](size_t idx) noexcept {
+            size_t seg = _seg_of(idx);
+            return _elems(_segs[seg].load(std::memory_order_acquire), _seg_size(seg))[idx - _seg_start(seg)];
+        }
+
+        const elemType& operator[](size_t idx) const noexcept {
+            size_t seg = _seg_of(idx);
+            return _elems(_segs[seg].load(std::memory_order_acquire), _seg_size(seg))[idx - _seg_start(seg)];
+        }
+
+        // call func(idx, element) for every published element
+        template <class Func>
+        void for_each(Func func) const {
+            size_t n = size();
+            for (size_t i = 0; i < n; ++i)
+                if (const elemType* p = _get(i)) func(i, *p);
+        }
+
+        // destroy every element and free the segments; needs exclusive access
+        void clear() noexcept {
+            _clean();
+        }
+    };
+}
+
+#endif // STLITE_CONCURRENT_VECTOR_HPP
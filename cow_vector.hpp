@@ -0,0 +1,273 @@
+#ifndef STLITE_COW_VECTOR_HPP
+#define STLITE_COW_VECTOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include "allocator.hpp"
+#include "exceptions.hpp"
+#include "vector.hpp"
+
+namespace s7a9 {
+    // Copy-on-write vector
+    // Copies share one buffer with an atomic reference count, so copying and
+    // assigning are O(1) and never touch the elements. The first non-const
+    // operation on a shared buffer clones it; const member functions never
+    // do, so handing snapshots to many readers costs one count each. Like any
+    // object, one cow_vector must not be changed by one thread while another
+    // uses it, but copies of it may be used and changed on different threads.
+    // A non-const reference or iterator taken before the vector is copied
+    // must not be written through afterwards: it points into the buffer the
+    // copy now shares, so the write would change the copy as well. Take it
+    // again after copying, which clones the buffer first.
+    template <class elemType, class Allocator = __malloc_allocator<elemType>>
+    class cow_vector {
+    public:
+        typedef vector<elemType, Allocator> vector_type;
+
+        typedef typename vector_type::iterator iterator;
+
+        typedef typename vector_type::const_iterator const_iterator;
+
+    private:
+        struct shared_block {
+            std::atomic<size_t> refs;
+            vector_type data;
+
+            shared_block() :
+                refs(1) {}
+
+            explicit shared_block(const vector_type& x) :
+                refs(1), data(x) {}
+        };
+
+        shared_block* _block; // nullptr only after being moved from
+
+        static const vector_type& _empty() {
+            static const vector_type empty;
+            return empty;
+        }
+
+        inline void _release() noexcept {
+            if (_block && _block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete _block;
+            _block = nullptr;
+        }
+
+        // the buffer for reading
+        inline const vector_type& _view() const {
+            return _block ? _block->data : _empty();
+        }
+
+        // the buffer for writing, cloned first if it is shared
+        vector_type& _mutable() {
+            if (_block == nullptr) {
+                _block = new shared_block();
+            }
+            else if (_block->refs.load(std::memory_order_acquire) != 1) {
+                shared_block* block = new shared_block(_block->data);
+                _release();
+                _block = block;
+            }
+            return _block->data;
+        }
+
+    public:
+        cow_vector() :
+            _block(new shared_block()) {}
+
+        explicit cow_vector(const vector_type& x) :
+            _block(new shared_block(x)) {}
+
+        cow_vector(size_t num, const elemType& value) :
+            _block(new shared_block(vector_type(num, value))) {}
+
+        cow_vector(const cow_vector& x) noexcept :
+            _block(x._block) {
+            if (_block) _block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        cow_vector(cow_vector&& x) noexcept :
+            _block(x._block) {
+            x._block = nullptr;
+        }
+
+        ~cow_vector() {
+            _release();
+        }
+
+        cow_vector& operator=(const cow_vector& rhs) noexcept {
+            if (_block == rhs._block) return *this;
+            if (rhs._block) rhs._block->refs.fetch_add(1, std::memory_order_relaxed);
+            _release();
+            _block = rhs._block;
+            return *this;
+        }
+
+        cow_vector& operator=(cow_vector&& rhs) noexcept {
+            if (this == &rhs) return *this;
+            _release();
+            _block = rhs._block;
+            rhs._block = nullptr;
+            return *this;
+        }
+
+        // number of cow_vectors sharing this buffer
+        size_t use_count() const noexcept {
+            return _block ? _block->refs.load(std::memory_order_relaxed) : 0;
+        }
+
+        // the elements, read-only and never cloned
+        const vector_type& view() const {
+            return _view();
+        }
+
+        // the elements for arbitrary changes, after cloning a shared buffer
+        vector_type& mutate() {
+            return _mutable();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return _view().empty();
+        }
+
+        size_t size() const {
+            return _view().size();
+        }
+
+        size_t capacity() const {
+            return _view().capacity();
+        }
+
+        const elemType& operator[](size_t idx) const {
+            return _view()[idx];
+        }
+
+        elemType& operator[](size_t idx) {
+            return _mutable()[idx];
+        }
+
+        const elemType& at(size_t idx) const {
+            return _view().at(idx);
+        }
+
+        elemType& at(size_t idx) {
+            return _mutable().at(idx);
+        }
+
+        const elemType& front() const {
+            return _view().front();
+        }
+
+        elemType& front() {
+            return _mutable().front();
+        }
+
+        const elemType& back() const {
+            return _view().back();
+        }
+
+        elemType& back() {
+            return _mutable().back();
+        }
+
+        const elemType* data() const {
+            return _view().data();
+        }
+
+        elemType* data() {
+            return _mutable().data();
+        }
+
+        const_iterator begin() const {
+            return _view().begin();
+        }
+
+        const_iterator cbegin() const {
+            return _view().cbegin();
+        }
+
+        iterator begin() {
+            return _mutable().begin();
+        }
+
+        const_iterator end() const {
+            return _view().end();
+        }
+
+        const_iterator cend() const {
+            return _view().cend();
+        }
+
+        iterator end() {
+            return _mutable().end();
+        }
+
+        void reserve(size_t num) {
+            _mutable().reserve(num);
+        }
+
+        void resize(size_t sz) {
+            _mutable().resize(sz);
+        }
+
+        void resize(size_t sz, const elemType& value) {
+            _mutable().resize(sz, value);
+        }
+
+        void shrink_to_fit() {
+            _mutable().shrink_to_fit();
+        }
+
+        void push_back(const elemType& x) {
+            _mutable().push_back(x);
+        }
+
+        void push_back(elemType&& x) {
+            _mutable().push_back(Move(x));
+        }
+
+        template <class... Args>
+        elemType& emplace_back(Args&&... args) {
+            return _mutable().emplace_back(Forward<Args>(args)...);
+        }
+
+        void pop_back() {
+            _mutable().pop_back();
+        }
+
+        iterator insert(size_t index, const elemType& x) {
+            return _mutable().insert(index, x);
+        }
+
+        iterator insert(size_t index, elemType&& x) {
+            return _mutable().insert(index, Move(x));
+        }
+
+        iterator erase(size_t idx) {
+            return _mutable().erase(idx);
+        }
+
+        template <class Pred>
+        size_t erase_if(Pred pred) {
+            return _mutable().erase_if(pred);
+        }
+
+        // destroy every element; a shared buffer is left to the other copies
+        // instead of being cloned
+        void clear() {
+            if (_block && _block->refs.load(std::memory_order_acquire) == 1) {
+                _block->data.clear();
+                return;
+            }
+            shared_block* block = new shared_block();
+            _release();
+            _block = block;
+        }
+
+        void swap(cow_vector& x) noexcept {
+            s7a9::swap(_block, x._block);
+        }
+    };
+}
+
+#endif // STLITE_COW_VECTOR_HPP
@@ -1,115 +1,340 @@
 #ifndef STLITE_DEQUE_HPP
 #define STLITE_DEQUE_HPP
 
+#include <cstddef>
+#include <iterator>
 #include "allocator.hpp"
 #include "exceptions.hpp"
 #include <initializer_list>
 
+// Default block size of a deque in bytes
+#ifndef DEQUE_BLOCK_BYTES
+#define DEQUE_BLOCK_BYTES 4096
+#endif
+
+// Emptied blocks a deque keeps for reuse
+#ifndef DEQUE_SPARE_BLOCKS
+#define DEQUE_SPARE_BLOCKS 4
+#endif
+
 namespace s7a9 {
 
+	// Double-ended queue
+	// Elements live in blocks of _num_per_block slots, each its own Allocator.
+	// A central map holds the block pointers in order and grows at both ends,
+	// so element i is slot (_start + i) % B of block (_start + i) / B: indexing
+	// is O(1), and pushing at either end never moves an element. Blocks exist
+	// only while they hold elements; a block that empties goes to a cache of
+	// up to DEQUE_SPARE_BLOCKS spare blocks and is reused by the next push, so
+	// a deque used as a queue stops allocating once it is warm. By default a
+	// block takes about DEQUE_BLOCK_BYTES bytes. Pushing may reallocate the
+	// map, which invalidates iterators but not references.
 	template <class elemType, class Allocator = __malloc_allocator<elemType>>
 	class deque {
+	public:
+		// Elements per block unless given to the constructor
+		static constexpr size_t DEFAULT_PER_BLOCK =
+			DEQUE_BLOCK_BYTES / sizeof(elemType) > 8 ? DEQUE_BLOCK_BYTES / sizeof(elemType) : 8;
+
 	private:
-		struct allocator_linknode {
-			Allocator* palloc;
-			allocator_linknode* next, * prev;
+		static constexpr size_t MIN_MAP_SIZE = 8, MAX_SPARE = DEQUE_SPARE_BLOCKS;
 
-			allocator_linknode() {
-				palloc = nullptr;
-				next = prev = nullptr;
-			}
-		};
+		Allocator** _map; // _map[b] is block b, or nullptr if it holds no element
 
-		allocator_linknode* _front, * _end;
+		size_t _map_size;
 
-		size_t _front_idx, _end_idx, _size, _num_per_block;
+		size_t _start; // Position of the front element, counted in slots from the start of the map
 
-		void _clean() {
-			if (_front == nullptr || _end == nullptr) return;
-			if (_front->prev) _front = _front->prev;
-			while (_front != _end) {
-				delete _front->palloc;
-				_front = _front->next;
-				delete _front->prev;
-			}
-			delete _end->palloc;
-			delete _end;
-			_front = _end = nullptr;
-			_front_idx = _end_idx = _size = 0;
+		size_t _size, _num_per_block;
+
+		Allocator _proto; // Empty allocator that new blocks are built from
+
+		Allocator* _spare[MAX_SPARE > 0 ? MAX_SPARE : 1]; // Empty blocks for reuse
+
+		size_t _spare_num;
+
+		inline Allocator*& _block(size_t pos) noexcept {
+			return _map[pos / _num_per_block];
 		}
 
-		inline void _expand_front() {
-			if (_front_idx == 0) {
-				if (_front->prev == nullptr) {
-					_front->prev = new allocator_linknode();
-					_front->prev->palloc = new Allocator(_num_per_block);
-					_front->prev->next = _front;
-				}
-				_front = _front->prev;
-				_front_idx = _num_per_block;
+		inline elemType* _slot(size_t pos) noexcept {
+			return _map[pos / _num_per_block]->data(pos % _num_per_block);
+		}
+
+		inline const elemType* _slot(size_t pos) const noexcept {
+			return _map[pos / _num_per_block]->data(pos % _num_per_block);
+		}
+
+		void _init_map() {
+			_map_size = MIN_MAP_SIZE;
+			_map = new Allocator * [_map_size]();
+			_start = _map_size / 2 * _num_per_block;
+			_size = 0;
+		}
+
+		// move the used blocks to the middle of a map with room for extra more
+		// blocks on the side that needs them, growing the map if it is crowded
+		void _remap(size_t extra, bool at_front) {
+			size_t first = _start / _num_per_block,
+				used = _size ? (_start + _size - 1) / _num_per_block - first + 1 : 0,
+				need = used + extra, map_size = _map_size;
+			if (need * 2 > _map_size) map_size = val_max(_map_size * 2, need * 2);
+			size_t new_first = (map_size - need) / 2 + (at_front ? extra : 0);
+			if (map_size != _map_size) {
+				Allocator** map = new Allocator * [map_size]();
+				for (size_t b = 0; b < used; ++b)
+					map[new_first + b] = _map[first + b];
+				delete[] _map;
+				_map = map;
+				_map_size = map_size;
+			}
+			else if (new_first < first) {
+				for (size_t b = 0; b < used; ++b)
+					_map[new_first + b] = _map[first + b], _map[first + b] = nullptr;
 			}
-			--_front_idx, ++_size;
+			else {
+				for (size_t b = used; b-- > 0;)
+					_map[new_first + b] = _map[first + b], _map[first + b] = nullptr;
+			}
+			_start = _start % _num_per_block + new_first * _num_per_block;
+		}
+
+		inline Allocator* _new_block() {
+			if (_spare_num) return _spare[--_spare_num];
+			return new Allocator(_num_per_block, _proto);
+		}
+
+		// keep an emptied block for reuse, or free it if the cache is full
+		inline void _recycle(Allocator* block) noexcept {
+			if (_spare_num < MAX_SPARE) _spare[_spare_num++] = block;
+			else delete block;
+		}
+
+		void _free_spare() noexcept {
+			while (_spare_num)
+				delete _spare[--_spare_num];
 		}
 
+		// make position pos (_start + _size) usable
 		inline void _expand_back() {
-			if (_end_idx == _end->palloc->length()) {
-				if (_end->next == nullptr) {
-					_end->next = new allocator_linknode();
-					_end->next->palloc = new Allocator(_num_per_block);
-					_end->next->prev = _end;
+			if ((_start + _size) / _num_per_block >= _map_size) _remap(1, false);
+			Allocator*& block = _block(_start + _size);
+			if (block == nullptr) block = _new_block();
+		}
+
+		// make position _start - 1 usable
+		inline void _expand_front() {
+			if (_start == 0) _remap(1, true);
+			Allocator*& block = _block(_start - 1);
+			if (block == nullptr) block = _new_block();
+		}
+
+		// give up the block of pos, which holds no element any more
+		inline void _drop_block(size_t pos) noexcept {
+			Allocator*& block = _block(pos);
+			_recycle(block);
+			block = nullptr;
+		}
+
+		void _clean() {
+			if (_map == nullptr) return;
+			clear();
+			_free_spare();
+			delete[] _map;
+			_map = nullptr;
+			_map_size = _start = 0;
+		}
+
+		// append the elements of other; trivially copyable elements go over in
+		// runs that stay inside one block on both sides, each a single memcpy
+		void _copy_from(const deque& other) {
+			if constexpr (__is_contiguous<Allocator>::value && std::is_trivially_copyable<elemType>::value) {
+				for (size_t i = 0; i < other._size;) {
+					_expand_back();
+					size_t src = other._start + i, dst = _start + _size,
+						n = val_min(other._size - i, val_min(_num_per_block - dst % _num_per_block,
+							other._num_per_block - src % other._num_per_block));
+					_block(dst)->construct_range(dst % _num_per_block, other._slot(src), n);
+					_size += n;
+					i += n;
 				}
-				_end = _end->next;
-				_end_idx = 0;
 			}
-			++_end_idx, ++_size;
+			else {
+				for (size_t i = 0; i < other._size; ++i)
+					push_back(*other._slot(other._start + i));
+			}
 		}
 
 	public:
-		deque() noexcept :
-			deque(256) {}
-
-		explicit deque(size_t num_per_block) noexcept :
-			_num_per_block(num_per_block) {
-			_front = _end = new allocator_linknode();
-			_front->palloc = new Allocator(num_per_block);
-			_front_idx = _end_idx = num_per_block / 2;
-			_size = 0;
+		// Random access iterator: a map entry and an offset in its block.
+		// Stepping moves to the next map entry at a block boundary, and blocks
+		// are only touched when dereferenced.
+		template <bool Const>
+		class deque_iterator {
+		private:
+			typedef std::conditional_t<Const, Allocator* const*, Allocator**> node_t;
+
+			node_t _node;
+
+			size_t _off, _num_per_block;
+
+			friend class deque;
+
+			template <bool> friend class deque_iterator;
+
+			deque_iterator(node_t node, size_t off, size_t num_per_block) noexcept :
+				_node(node), _off(off), _num_per_block(num_per_block) {}
+
+		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef elemType value_type;
+			typedef ptrdiff_t difference_type;
+			typedef std::conditional_t<Const, const elemType*, elemType*> pointer;
+			typedef std::conditional_t<Const, const elemType&, elemType&> reference;
+
+			deque_iterator() noexcept :
+				_node(nullptr), _off(0), _num_per_block(1) {}
+
+			template <bool C, class = std::enable_if_t<Const && !C>>
+			deque_iterator(const deque_iterator<C>& iter) noexcept :
+				_node(iter._node), _off(iter._off), _num_per_block(iter._num_per_block) {}
+
+			inline reference operator*() const noexcept {
+				return *((*_node)->data(_off));
+			}
+
+			inline pointer operator->() const noexcept {
+				return (*_node)->data(_off);
+			}
+
+			inline reference operator[](ptrdiff_t offset) const noexcept {
+				return *(*this + offset);
+			}
+
+			inline deque_iterator& operator++() noexcept {
+				if (++_off == _num_per_block) ++_node, _off = 0;
+				return *this;
+			}
+
+			inline deque_iterator operator++(int) noexcept {
+				deque_iterator iter(*this);
+				++*this;
+				return iter;
+			}
+
+			inline deque_iterator& operator--() noexcept {
+				if (_off == 0) --_node, _off = _num_per_block;
+				--_off;
+				return *this;
+			}
+
+			inline deque_iterator operator--(int) noexcept {
+				deque_iterator iter(*this);
+				--*this;
+				return iter;
+			}
+
+			deque_iterator& operator+=(ptrdiff_t offset) noexcept {
+				ptrdiff_t pos = ptrdiff_t(_off) + offset, blocks = ptrdiff_t(_num_per_block);
+				ptrdiff_t step = pos >= 0 ? pos / blocks : -((-pos - 1) / blocks) - 1;
+				_node += step;
+				_off = size_t(pos - step * blocks);
+				return *this;
+			}
+
+			inline deque_iterator& operator-=(ptrdiff_t offset) noexcept {
+				return *this += -offset;
+			}
+
+			inline deque_iterator operator+(ptrdiff_t offset) const noexcept {
+				deque_iterator iter(*this);
+				return iter += offset;
+			}
+
+			inline deque_iterator operator-(ptrdiff_t offset) const noexcept {
+				deque_iterator iter(*this);
+				return iter += -offset;
+			}
+
+			friend inline ptrdiff_t operator-(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+				return (lhs._node - rhs._node) * ptrdiff_t(lhs._num_per_block) +
+					ptrdiff_t(lhs._off) - ptrdiff_t(rhs._off);
+			}
+
+			inline bool operator==(const deque_iterator& rhs) const noexcept {
+				return _node == rhs._node && _off == rhs._off;
+			}
+
+			inline bool operator!=(const deque_iterator& rhs) const noexcept {
+				return !(*this == rhs);
+			}
+
+			inline bool operator<(const deque_iterator& rhs) const noexcept {
+				return *this - rhs < 0;
+			}
+
+			inline bool operator>(const deque_iterator& rhs) const noexcept {
+				return rhs < *this;
+			}
+
+			inline bool operator<=(const deque_iterator& rhs) const noexcept {
+				return !(rhs < *this);
+			}
+
+			inline bool operator>=(const deque_iterator& rhs) const noexcept {
+				return !(*this < rhs);
+			}
+		};
+
+		typedef deque_iterator<false> iterator;
+
+		typedef deque_iterator<true> const_iterator;
+
+		deque() :
+			deque(DEFAULT_PER_BLOCK) {}
+
+		explicit deque(size_t num_per_block) :
+			_num_per_block(num_per_block), _proto(0), _spare(), _spare_num(0) {
+			_init_map();
+		}
+
+		// empty deque whose blocks are built from alloc_arg, e.g. the
+		// std::pmr::memory_resource* of a __pmr_allocator
+		template <class Arg, class = std::enable_if_t<
+			std::is_constructible<Allocator, size_t, Arg&&>::value>>
+		deque(Arg&& alloc_arg, size_t num_per_block) :
+			_num_per_block(num_per_block), _proto(0, Forward<Arg>(alloc_arg)), _spare(), _spare_num(0) {
+			_init_map();
 		}
 
-		deque(std::initializer_list<elemType> init, 
-			size_t num_per_block = 256) : 
+		template <class Arg, class = std::enable_if_t<
+			std::is_constructible<Allocator, size_t, Arg&&>::value>>
+		explicit deque(Arg&& alloc_arg) :
+			deque(Forward<Arg>(alloc_arg), DEFAULT_PER_BLOCK) {}
+
+		deque(std::initializer_list<elemType> init,
+			size_t num_per_block = DEFAULT_PER_BLOCK) :
 			deque(num_per_block) {
 			for (auto i = init.begin(); i != init.end(); ++i) {
 				push_back(*i);
 			}
 		}
 
-		deque(const deque& other) {
-			allocator_linknode* cur_node, * lst_node = nullptr;
-			_front = cur_node = new allocator_linknode();
-			for (allocator_linknode* node = other._front; 
-				; node = node->next) {
-				cur_node->palloc = new Allocator(*node->palloc);
-				cur_node->prev = lst_node;
-				if (lst_node) lst_node->next = cur_node;
-				if (node != other._end) {
-					cur_node = new allocator_linknode();
-					lst_node = cur_node;
-				}
-				else break;
-			}
-			_end = cur_node;
-			_front_idx = other._front_idx, _end_idx = other._end_idx;
-			_size = other._size, _num_per_block = other._num_per_block;
+		deque(const deque& other) :
+			_num_per_block(other._num_per_block), _proto(0, other._proto), _spare(), _spare_num(0) {
+			_init_map();
+			_copy_from(other);
 		}
 
-		deque(deque&& other) noexcept {
-			_front = other._front, _end = other._end;
-			_front_idx = other._front_idx, _end_idx = other._end_idx;
-			_size = other._size, _num_per_block = other._num_per_block;
-			other._front = other._end = nullptr;
-			other._size = other._front_idx = other._end_idx = 0;
-			other._num_per_block = 0;
+		deque(deque&& other) noexcept :
+			_map(other._map), _map_size(other._map_size), _start(other._start),
+			_size(other._size), _num_per_block(other._num_per_block), _proto(Move(other._proto)),
+			_spare(), _spare_num(other._spare_num) {
+			for (size_t i = 0; i < _spare_num; ++i)
+				_spare[i] = other._spare[i];
+			other._spare_num = 0;
+			other._map = nullptr;
+			other._map_size = other._start = other._size = 0;
 		}
 
 		~deque() {
@@ -117,76 +342,56 @@ namespace s7a9 {
 		}
 
 		deque& operator=(const deque& other) {
-			_clean();
-			allocator_linknode* cur_node, * lst_node = nullptr;
-			_front = cur_node = new allocator_linknode();
-			for (allocator_linknode* node = other._front;
-				; node = node->next) {
-				cur_node->palloc = new Allocator(*node->palloc);
-				cur_node->prev = lst_node;
-				if (lst_node) lst_node->next = cur_node;
-				if (node != other._end) {
-					cur_node = new allocator_linknode();
-					lst_node = cur_node;
-				}
-				else break;
-			}
-			_end = cur_node;
-			_front_idx = other._front_idx, _end_idx = other._end_idx;
-			_size = other._size, _num_per_block = other._num_per_block;
+			if (this == &other) return *this;
+			clear();
+			if (_map == nullptr) _init_map();
+			_copy_from(other);
+			return *this;
 		}
 
-		deque& operator=(deque&& other) {
+		deque& operator=(deque&& other) noexcept {
+			if (this == &other) return *this;
 			_clean();
-			_front = other._front, _end = other._end;
-			_front_idx = other._front_idx, _end_idx = other._end_idx;
-			_size = other._size, _num_per_block = other._num_per_block;
-			other._front = other._end = nullptr;
-			other._size = other._front_idx = other._end_idx = 0;
-			other._num_per_block = 0;
+			swap(other);
+			return *this;
 		}
 
 		elemType& at(size_t idx) {
-			size_t i = 0, i_blk = _front_idx;
-			allocator_linknode* node = _front;
-			while (i < idx) {
-				++i_blk, ++i;
-				if (i_blk == node->palloc->length()) {
-					i_blk = 0;
-					if (node == _end) {
-						throw sjtu::index_out_of_bound();
-					}
-					node = node->next;
-				}
-			}
-			return *(_front->palloc->data(i_blk));
+			if (idx >= _size) throw sjtu::index_out_of_bound();
+			return *_slot(_start + idx);
+		}
+
+		const elemType& at(size_t idx) const {
+			if (idx >= _size) throw sjtu::index_out_of_bound();
+			return *_slot(_start + idx);
 		}
 
 		elemType& operator[](size_t idx) noexcept {
-			size_t i = 0, i_blk = _front_idx;
-			allocator_linknode* node = _front;
-			while (i < idx) {
-				++i_blk, ++i;
-				if (i_blk == node->palloc->length()) {
-					i_blk = 0;
-					node = node->next;
-				}
-			}
-			return *(_front->palloc->data(i_blk));
+			return *_slot(_start + idx);
+		}
+
+		const elemType& operator[](size_t idx) const noexcept {
+			return *_slot(_start + idx);
 		}
 
 		elemType& front() {
 			if (_size == 0) throw sjtu::container_is_empty();
-			return *(_front->palloc->data(_front_idx));
+			return *_slot(_start);
+		}
+
+		const elemType& front() const {
+			if (_size == 0) throw sjtu::container_is_empty();
+			return *_slot(_start);
 		}
 
 		elemType& back() {
 			if (_size == 0) throw sjtu::container_is_empty();
-			if (_end_idx == 0) {
-				auto palloc = _end->prev->palloc;
-				return *(palloc->data(palloc->length() - 1));
-			}
-			return *(_end->palloc->data(_end_idx - 1));
+			return *_slot(_start + _size - 1);
+		}
+
+		const elemType& back() const {
+			if (_size == 0) throw sjtu::container_is_empty();
+			return *_slot(_start + _size - 1);
 		}
 
 		[[nodiscard]] inline bool empty() const {
@@ -197,73 +402,160 @@ namespace s7a9 {
 			return _size;
 		}
 
+		iterator begin() noexcept {
+			return iterator(_map + _start / _num_per_block, _start % _num_per_block, _num_per_block);
+		}
+
+		const_iterator begin() const noexcept {
+			return const_iterator(_map + _start / _num_per_block, _start % _num_per_block, _num_per_block);
+		}
+
+		const_iterator cbegin() const noexcept {
+			return begin();
+		}
+
+		iterator end() noexcept {
+			size_t pos = _start + _size;
+			return iterator(_map + pos / _num_per_block, pos % _num_per_block, _num_per_block);
+		}
+
+		const_iterator end() const noexcept {
+			size_t pos = _start + _size;
+			return const_iterator(_map + pos / _num_per_block, pos % _num_per_block, _num_per_block);
+		}
+
+		const_iterator cend() const noexcept {
+			return end();
+		}
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+		// allocation counters summed over all blocks and the prototype
+		alloc_stats stats() const {
+			alloc_stats ret = _proto.stats();
+			for (size_t b = 0; b < _map_size; ++b)
+				if (_map[b]) ret += _map[b]->stats();
+			for (size_t i = 0; i < _spare_num; ++i)
+				ret += _spare[i]->stats();
+			return ret;
+		}
+#endif
+
+		// destroy every element, keeping the map and up to DEQUE_SPARE_BLOCKS blocks
 		void clear() {
-			_clean();
-			_front = _end = new allocator_linknode();
-			_front->palloc = new Allocator(_num_per_block);
-			_front_idx = _end_idx = _num_per_block / 2;
+			if (_map == nullptr) return;
+			for (size_t i = 0; i < _size; ++i)
+				_block(_start + i)->remove((_start + i) % _num_per_block);
+			for (size_t b = 0; b < _map_size; ++b) {
+				if (_map[b]) _recycle(_map[b]);
+				_map[b] = nullptr;
+			}
+			_start = _map_size / 2 * _num_per_block;
+			_size = 0;
+		}
+
+		// free the spare blocks
+		void shrink_to_fit() noexcept {
+			_free_spare();
 		}
 
 		void push_back(const elemType& x) {
-			_expand_back();
-			_end->palloc->construct(_end_idx - 1, x);
+			emplace_back(x);
 		}
 
 		void push_back(elemType&& x) {
+			emplace_back(Move(x));
+		}
+
+		template <class... Args>
+		elemType& emplace_back(Args&&... args) {
+			if (_map == nullptr) _init_map();
 			_expand_back();
-			_end->palloc->construct(_end_idx - 1, x);
+			size_t pos = _start + _size;
+			_block(pos)->emplace(pos % _num_per_block, Forward<Args>(args)...);
+			++_size;
+			return *_slot(pos);
 		}
 
+		// popping an empty deque does nothing
 		void pop_back() {
 			if (_size == 0) return;
-			if (_end_idx == 0) {
-				if (_end->next) {
-					delete _end->next->palloc;
-					delete _end->next;
-					_end->next = nullptr;
-				}
-				_end = _end->prev;
-				_end_idx = _end->palloc->length();
-			}
-			--_end_idx, --_size;
-			_end->palloc->remove(_end_idx);
+			size_t pos = _start + --_size;
+			_block(pos)->remove(pos % _num_per_block);
+			if (pos % _num_per_block == 0 || _size == 0) _drop_block(pos);
 		}
 
 		void push_front(const elemType& x) {
-			_expand_front();
-			_front->palloc->construct(_front_idx, x);
+			emplace_front(x);
 		}
 
 		void push_front(elemType&& x) {
+			emplace_front(Move(x));
+		}
+
+		template <class... Args>
+		elemType& emplace_front(Args&&... args) {
+			if (_map == nullptr) _init_map();
 			_expand_front();
-			_front->palloc->construct(_front_idx, x);
+			_block(_start - 1)->emplace((_start - 1) % _num_per_block, Forward<Args>(args)...);
+			--_start, ++_size;
+			return *_slot(_start);
 		}
 
 		void pop_front() {
-			_front->palloc->remove(_front_idx);
-			++_front_idx, --_size;
-			if (_front_idx == _front->palloc->length()) {
-				if (_front->prev) {
-					delete _front->prev->palloc;
-					delete _front->prev;
-					_front->prev = nullptr;
+			if (_size == 0) return;
+			size_t pos = _start++;
+			_block(pos)->remove(pos % _num_per_block);
+			--_size;
+			if (_start % _num_per_block == 0 || _size == 0) _drop_block(pos);
+		}
+
+		// remove every element matching pred in one pass, keeping the order of
+		// the others, and return how many were removed
+		template <class Pred>
+		size_t erase_if(Pred pred) {
+			iterator wit = begin();
+			size_t kept = 0;
+			for (iterator rit = begin(), last = end(); rit != last; ++rit) {
+				if (pred(*rit)) continue;
+				if (rit != wit) *wit = Move(*rit);
+				++kept, ++wit;
+			}
+			size_t removed = _size - kept;
+			while (_size > kept) pop_back();
+			return removed;
+		}
+
+		// erase_if() that fills each hole with the last element instead of
+		// shifting, so the order of the remaining elements is not kept
+		template <class Pred>
+		size_t erase_if_unstable(Pred pred) {
+			size_t old_size = _size;
+			for (size_t i = 0; i < _size;) {
+				elemType& x = (*this)[i];
+				if (!pred(x)) {
+					++i;
+					continue;
 				}
-				_front = _front->next;
-				_front_idx = 0;
+				if (i + 1 != _size) x = Move(back());
+				pop_back();
 			}
+			return old_size - _size;
 		}
 
 		void swap(deque& other) {
-			s7a9::swap(_front, other._front);
-			s7a9::swap(_end, other._end);
-			s7a9::swap(_num_per_block, other._num_per_block);
-			s7a9::swap(_front_idx, other._front_idx);
-			s7a9::swap(_end_idx, other._end_idx);
+			s7a9::swap(_map, other._map);
+			s7a9::swap(_map_size, other._map_size);
+			s7a9::swap(_start, other._start);
 			s7a9::swap(_size, other._size);
+			s7a9::swap(_num_per_block, other._num_per_block);
+			_proto.swap(other._proto);
+			for (size_t i = 0; i < MAX_SPARE; ++i)
+				s7a9::swap(_spare[i], other._spare[i]);
+			s7a9::swap(_spare_num, other._spare_num);
 		}
 
 	};
 
 }
 
-#endif // STLITE_DEQUE_HPP
\ No newline at end of file
+#endif // STLITE_DEQUE_HPP
@@ -32,15 +32,21 @@ namespace sjtu {
 			data(data), prev(nullptr), next(nullptr), hash_next(nullptr) {}
 
 		explicit _hashnode_t(T&& data) :
-			data(data), prev(nullptr), next(nullptr), hash_next(nullptr) {}
+			data(std::move(data)), prev(nullptr), next(nullptr), hash_next(nullptr) {}
+
+		// construct data in place from args
+		template <class... Args>
+		explicit _hashnode_t(std::in_place_t, Args&&... args) :
+			data(std::forward<Args>(args)...), prev(nullptr), next(nullptr), hash_next(nullptr) {}
 	};
 
 	template<
 		class Key,
 		class T,
 		class Hash = std::hash<Key>,
-		class Equal = std::equal_to<Key>
-	> class linked_hashmap : protected list<pair<Key, T>, _hashnode_t<pair<Key, T>>> {
+		class Equal = std::equal_to<Key>,
+		template <class> class NodeAllocator = s7a9::__pool_allocator
+	> class linked_hashmap : protected list<pair<Key, T>, _hashnode_t<pair<Key, T>>, NodeAllocator> {
 	public:
 		/**
 		 * the internal type of data.
@@ -52,7 +58,7 @@ namespace sjtu {
 	private:
 		static const size_t INITAL_CAPACITY = 129, LOAD_FACTOR = 75;
 
-		using list_t = list<pair<Key, T>, _hashnode_t<pair<Key, T>>>;
+		using list_t = list<pair<Key, T>, _hashnode_t<pair<Key, T>>, NodeAllocator>;
 
 		using linknode_t = typename list_t::node;
 
@@ -106,6 +112,18 @@ namespace sjtu {
 			std::fill(_table, _table + _table_size, nullptr);
 		}
 
+		/**
+		 * empty linked_hashmap whose node allocator is built from alloc_arg,
+		 * e.g. the std::pmr::memory_resource* of a __pmr_node_allocator
+		 */
+		template <class Arg, class = std::enable_if_t<
+			std::is_constructible<NodeAllocator<linknode_t>, Arg&&>::value>>
+		explicit linked_hashmap(Arg&& alloc_arg) :
+			list_t::list(std::forward<Arg>(alloc_arg)), _table_size(INITAL_CAPACITY) {
+			_table = new linknode_t * [_table_size];
+			std::fill(_table, _table + _table_size, nullptr);
+		}
+
 		linked_hashmap(const linked_hashmap& other) :
 			list_t::list(other), _table_size(other._table_size) {
 			_table = new linknode_t * [_table_size];
@@ -161,7 +179,8 @@ namespace sjtu {
 				_expand();
 			linknode_t*& node = _find(key);
 			if (node) return node->data.second;
-			node = this->_insert(nullptr, new linknode_t(pair<Key, T>(key, T())));
+			node = this->_insert(nullptr, this->_new_node(std::in_place, std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple()));
 			return node->data.second;
 		}
 
@@ -210,6 +229,15 @@ namespace sjtu {
 			return this->_size;
 		}
 
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+		/**
+		 * allocation counters of the node allocator (the bucket table is not included)
+		 */
+		s7a9::alloc_stats stats() const {
+			return list_t::stats();
+		}
+#endif
+
 		/**
 		 * clears the contents
 		 */
@@ -225,7 +253,7 @@ namespace sjtu {
 		 *   the second one is true if insert successfully, or false.
 		 */
 		inline pair<iterator, bool> insert(const value_type& value) {
-			return insert(std::move(value_type(value)));
+			return insert(value_type(value));
 		}
 
 		pair<iterator, bool> insert(value_type&& value) {
@@ -235,7 +263,51 @@ namespace sjtu {
 			if (pos && _equal(value.first, pos->data.first)) {
 				return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), false);
 			}
-			pos = this->_insert(nullptr, new linknode_t(value));
+			pos = this->_insert(nullptr, this->_new_node(std::in_place, std::move(value)));
+			return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), true);
+		}
+
+		/**
+		 * construct an element in place from args, unless its key already exists.
+		 * the element is built first to learn its key, and destroyed again if it is a duplicate.
+		 */
+		template <class... Args>
+		pair<iterator, bool> emplace(Args&&... args) {
+			if (this->_size >= _table_size * LOAD_FACTOR / 100)
+				_expand();
+			linknode_t* nd = this->_new_node(std::in_place, std::forward<Args>(args)...);
+			linknode_t*& pos = _find(nd->data.first);
+			if (pos) {
+				this->_delete_node(nd);
+				return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), false);
+			}
+			pos = this->_insert(nullptr, nd);
+			return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), true);
+		}
+
+		/**
+		 * if key does not exist, insert an element whose value is constructed in place from args.
+		 * nothing is constructed when key already exists.
+		 */
+		template <class... Args>
+		pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+			if (this->_size >= _table_size * LOAD_FACTOR / 100)
+				_expand();
+			linknode_t*& pos = _find(key);
+			if (pos) return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), false);
+			pos = this->_insert(nullptr, this->_new_node(std::in_place, std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)));
+			return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), true);
+		}
+
+		template <class... Args>
+		pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+			if (this->_size >= _table_size * LOAD_FACTOR / 100)
+				_expand();
+			linknode_t*& pos = _find(key);
+			if (pos) return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), false);
+			pos = this->_insert(nullptr, this->_new_node(std::in_place, std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)));
 			return sjtu::pair<iterator, bool>(iterator(pos, &this->_end), true);
 		}
 
@@ -258,7 +330,7 @@ namespace sjtu {
 			if (node == nullptr) return end();
 			iterator ret_iter(this->_erase(node), &this->_end);
 			node = node->hash_next;
-			delete tmp_node;
+			this->_delete_node(tmp_node);
 			return ret_iter;
 		}
 
@@ -2,9 +2,11 @@
 #define SJTU_LIST_HPP
 
 #include "exceptions.hpp"
+#include "allocator.hpp"
 
 #include <climits>
 #include <cstddef>
+#include <utility>
 
 namespace sjtu {
 
@@ -18,15 +20,24 @@ namespace sjtu {
             data(data), prev(nullptr), next(nullptr) {}
 
         explicit _listnode_t(T&& data) :
-            data(data), prev(nullptr), next(nullptr) {}
+            data(std::move(data)), prev(nullptr), next(nullptr) {}
+
+        // construct data in place from args
+        template <class... Args>
+        explicit _listnode_t(std::in_place_t, Args&&... args) :
+            data(std::forward<Args>(args)...), prev(nullptr), next(nullptr) {}
     };
 
     /**
      * a data container like std::list
      * allocate random memory addresses for data and they are doubly-linked in a list.
+     * nodes are obtained from NodeAllocator, a slab pool by default.
      */
-    template<typename T, class node_t = _listnode_t<T>>
-    class list {
+    template<
+        typename T,
+        class node_t = _listnode_t<T>,
+        template <class> class NodeAllocator = s7a9::__pool_allocator
+    > class list {
     protected:
         /**
          * add data members for linked list as protected members
@@ -37,6 +48,26 @@ namespace sjtu {
 
         size_t _size;
 
+        NodeAllocator<node> _node_alloc;
+
+        template <class... Args>
+        node* _new_node(Args&&... args) {
+            node* nd = _node_alloc.allocate();
+            try {
+                new(nd) node(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                _node_alloc.deallocate(nd);
+                throw;
+            }
+            return nd;
+        }
+
+        inline void _delete_node(node* nd) noexcept {
+            nd->~node();
+            _node_alloc.deallocate(nd);
+        }
+
         /**
          * insert node cur before node pos
          * return the inserted node cur
@@ -95,11 +126,14 @@ namespace sjtu {
 
         void _clear() {
             if (_begin == nullptr || _end == nullptr) return;
-            while (_begin != _end) {
-                _begin = _begin->next;
-                delete _begin->prev;
+            if (!s7a9::__skip_destroy<NodeAllocator<node>, node>::value) {
+                while (_begin != _end) {
+                    _begin = _begin->next;
+                    _delete_node(_begin->prev);
+                }
+                _delete_node(_end);
             }
-            delete _end;
+            _node_alloc.release();
             _begin = _end = nullptr;
             _size = 0;
         }
@@ -298,16 +332,27 @@ namespace sjtu {
          */
         list() : _begin(nullptr), _end(nullptr), _size(0) {}
 
-        list(const list& other) {
+        /**
+         * empty list whose node allocator is built from alloc_arg,
+         * e.g. the std::pmr::memory_resource* of a __pmr_node_allocator
+         */
+        template <class Arg, class = std::enable_if_t<
+            std::is_constructible<NodeAllocator<node>, Arg&&>::value>>
+        explicit list(Arg&& alloc_arg) :
+            _begin(nullptr), _end(nullptr), _size(0), _node_alloc(std::forward<Arg>(alloc_arg)) {}
+
+        list(const list& other) :
+            _node_alloc(other._node_alloc) {
             _begin = _end = nullptr;
             _size = 0;
             for (node* nd = other._begin; nd; nd = nd->next) {
-                _insert(nullptr, new node(nd->data));
+                _insert(nullptr, _new_node(nd->data));
             }
         }
 
         list(list&& other) :
-            _begin(other._begin), _end(other._end), _size(other._size) {
+            _begin(other._begin), _end(other._end), _size(other._size),
+            _node_alloc(std::move(other._node_alloc)) {
             other._begin = other._end = nullptr;
             other._size = 0;
         }
@@ -324,7 +369,7 @@ namespace sjtu {
             if (this == &other) return *this;
             _clear();
             for (node* nd = other._begin; nd; nd = nd->next) {
-                _insert(nullptr, new node(nd->data));
+                _insert(nullptr, _new_node(nd->data));
             }
             return *this;
         }
@@ -344,17 +389,17 @@ namespace sjtu {
          * returns an iterator to the beginning.
          */
         iterator begin() {
-            return iterator(_begin, _end);
+            return iterator(_begin, &_end);
         }
 
         const_iterator cbegin() const {
-            return const_iterator(_begin, _end);
+            return const_iterator(_begin, &_end);
         }
         /**
          * returns an iterator to the end.
          */
         iterator end() {
-            return iterator(nullptr, _end);
+            return iterator(nullptr, &_end);
         }
         const_iterator cend() const {
             return const_iterator(nullptr, &_end);
@@ -372,6 +417,15 @@ namespace sjtu {
             return _size;
         }
 
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        /**
+         * allocation counters of the node allocator
+         */
+        s7a9::alloc_stats stats() const {
+            return _node_alloc.stats();
+        }
+#endif
+
         /**
          * clears the contents
          */
@@ -385,12 +439,22 @@ namespace sjtu {
          */
         virtual iterator insert(iterator pos, const T& value) {
             if (&_end != pos._end) throw invalid_iterator();
-            return iterator(_insert(pos._p, new node(value)), &_end);
+            return iterator(_insert(pos._p, _new_node(value)), &_end);
         }
 
         virtual iterator insert(iterator pos, T&& value) {
             if (&_end != pos._end) throw invalid_iterator();
-            return iterator(_insert(pos._p, new node(value)), &_end);
+            return iterator(_insert(pos._p, _new_node(std::move(value))), &_end);
+        }
+
+        /**
+         * construct an element in place before pos (pos may be the end() iterator)
+         * return an iterator pointing to the new element
+         */
+        template <class... Args>
+        iterator emplace(iterator pos, Args&&... args) {
+            if (&_end != pos._end) throw invalid_iterator();
+            return iterator(_insert(pos._p, _new_node(std::in_place, std::forward<Args>(args)...)), &_end);
         }
         /**
          * remove the element at pos (the end() iterator is invalid)
@@ -401,18 +465,23 @@ namespace sjtu {
             if (empty()) throw sjtu::container_is_empty();
             if (pos._p == nullptr) throw sjtu::invalid_iterator();
             iterator ret(_erase(pos._p), &_end);
-            delete pos._p;
+            _delete_node(pos._p);
             return ret;
         }
         /**
          * adds an element to the end
          */
         void push_back(const T& value) {
-            _insert(nullptr, new node(value));
+            _insert(nullptr, _new_node(value));
         }
 
         void push_back(T&& value) {
-            _insert(nullptr, new node(value));
+            _insert(nullptr, _new_node(std::move(value)));
+        }
+
+        template <class... Args>
+        T& emplace_back(Args&&... args) {
+            return _insert(nullptr, _new_node(std::in_place, std::forward<Args>(args)...))->data;
         }
         /**
          * removes the last element
@@ -422,17 +491,22 @@ namespace sjtu {
             if (empty()) throw sjtu::container_is_empty();
             node* nd = _end;
             _erase(_end);
-            delete nd;
+            _delete_node(nd);
         }
         /**
          * inserts an element to the beginning.
          */
         void push_front(const T& value) {
-            _insert(_begin, new node(value));
+            _insert(_begin, _new_node(value));
         }
 
         void push_front(T&& value) {
-            _insert(_begin, new node(value));
+            _insert(_begin, _new_node(std::move(value)));
+        }
+
+        template <class... Args>
+        T& emplace_front(Args&&... args) {
+            return _insert(_begin, _new_node(std::in_place, std::forward<Args>(args)...))->data;
         }
         /**
          * removes the first element.
@@ -442,7 +516,7 @@ namespace sjtu {
             if (empty()) throw sjtu::container_is_empty();
             node* nd = _begin;
             _erase(_begin);
-            delete nd;
+            _delete_node(nd);
         }
         /**
          * sort the values in ascending order with operator< of T
@@ -469,6 +543,7 @@ namespace sjtu {
          * no elements are copied or moved
          */
         void merge(list& other) {
+            _node_alloc.merge(other._node_alloc);
             node* nd1 = _begin, * nd2 = other._begin, * tmp_pnd;
             _begin = _end = other._begin = other._end = nullptr;
             _size = other._size = 0;
@@ -520,7 +595,7 @@ namespace sjtu {
                 if (nd->data == nd->next->data) {
                     nxt_nd = nd->next;
                     _erase(nd->next);
-                    delete nxt_nd;
+                    _delete_node(nxt_nd);
                 }
                 else {
                     nd = nd->next;
@@ -10,13 +10,15 @@
 #include <cstddef>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "allocator.hpp"
 
 namespace sjtu {
 
 	template<
 		class Key,
 		class T,
-		class Compare = std::less<Key>
+		class Compare = std::less<Key>,
+		template <class> class NodeAllocator = s7a9::__pool_allocator
 	> class map {
 	public:
 		/**
@@ -28,7 +30,7 @@ namespace sjtu {
 
 	private:
 		struct Node {
-			static const bool RED = true, BLK = false;
+			static constexpr bool RED = true, BLK = false;
 
 			bool _clr;
 
@@ -41,7 +43,7 @@ namespace sjtu {
 				Node* fa = nullptr, 
 				Node* ls = nullptr, 
 				Node* rs = nullptr) :
-				_val(val), _clr(color), _fa(fa) {
+				_val(std::move(val)), _clr(color), _fa(fa) {
 				_son[0] = ls; _son[1] = rs;
 			}
 
@@ -54,6 +56,13 @@ namespace sjtu {
 				_son[0] = ls; _son[1] = rs;
 			}
 
+			// construct _val in place from args
+			template <class... Args>
+			Node(bool color, Node* fa, std::in_place_t, Args&&... args) :
+				_clr(color), _val(std::forward<Args>(args)...), _fa(fa) {
+				_son[0] = _son[1] = nullptr;
+			}
+
 			Node* succ() {
 				Node* nd = _son[1];
 				while (nd->_son[0])
@@ -141,19 +150,48 @@ namespace sjtu {
 
 		Compare _comp;
 
-		static Node* _copy_recursive(const Node* nd, Node* fa) {
+		NodeAllocator<Node> _node_alloc;
+
+		template <class... Args>
+		Node* _new_node(Args&&... args) {
+			Node* nd = _node_alloc.allocate();
+			try {
+				new(nd) Node(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				_node_alloc.deallocate(nd);
+				throw;
+			}
+			return nd;
+		}
+
+		inline void _delete_node(Node* nd) noexcept {
+			nd->~Node();
+			_node_alloc.deallocate(nd);
+		}
+
+		Node* _copy_recursive(const Node* nd, Node* fa) {
 			if (nd == nullptr) return nullptr;
-			Node* ret = new Node(nd->_val, nd->_clr, fa);
+			Node* ret = _new_node(nd->_val, nd->_clr, fa);
 			ret->_son[0] = _copy_recursive(nd->_son[0], ret);
 			ret->_son[1] = _copy_recursive(nd->_son[1], ret);
 			return ret;
 		}
 
-		static void _clear_recursive(Node* nd) {
+		void _clear_recursive(Node* nd) {
 			if (nd == nullptr) return;
 			_clear_recursive(nd->_son[0]);
 			_clear_recursive(nd->_son[1]);
-			delete nd;
+			_delete_node(nd);
+		}
+
+		// destroy the whole tree and hand all node memory back at once
+		inline void _clear() {
+			if (!s7a9::__skip_destroy<NodeAllocator<Node>, Node>::value)
+				_clear_recursive(_root);
+			_node_alloc.release();
+			_root = nullptr;
+			_size = 0;
 		}
 
 		// If found, return true and pos is set to corresponding node
@@ -232,11 +270,11 @@ namespace sjtu {
 				_solve_double_black(pos);
 			if (pos == _root) {
 				_root = nullptr;
-				delete pos;
+				_delete_node(pos);
 				return;
 			}
 			pos->_fa->_son[pos->_fa->_son[1] == pos] = nullptr;
-			delete pos;
+			_delete_node(pos);
 			return;
 		}
 
@@ -336,7 +374,7 @@ namespace sjtu {
 			 */
 			friend const_iterator;
 			
-			friend sjtu::map<Key, T, Compare>;
+			friend map;
 
 			// Used to mark the difference between 
 			// *begin* and *end* iterator of an empty map
@@ -465,7 +503,7 @@ namespace sjtu {
 		private:
 			friend iterator;
 
-			friend map<Key, T, Compare>;
+			friend map;
 
 			// Same function as in iterator
 			bool _end_pos;
@@ -590,20 +628,33 @@ namespace sjtu {
 		map() noexcept :
 			_root(nullptr), _size(0) {}
 
+		/**
+		 * empty map whose node allocator is built from alloc_arg,
+		 * e.g. the std::pmr::memory_resource* of a __pmr_node_allocator
+		 */
+		template <class Arg, class = std::enable_if_t<
+			std::is_constructible<NodeAllocator<Node>, Arg&&>::value>>
+		explicit map(Arg&& alloc_arg) :
+			_root(nullptr), _size(0), _node_alloc(std::forward<Arg>(alloc_arg)) {}
+
 		map(const map& other) :
-			_size(other._size) {
+			_size(other._size), _node_alloc(other._node_alloc) {
 			_root = _copy_recursive(other._root, nullptr);
 		}
 
 		map(map&& other) noexcept :
-			_size(other._size), _root(other._root) {}
+			_root(other._root), _size(other._size),
+			_node_alloc(std::move(other._node_alloc)) {
+			other._root = nullptr;
+			other._size = 0;
+		}
 
 		/**
 		 * TODO assignment operator
 		 */
 		map& operator=(const map& other) {
 			if (this == &other) return *this;
-			_clear_recursive(_root);
+			_clear();
 			_size = other._size;
 			_root = _copy_recursive(other._root, nullptr);
 			return *this;
@@ -612,7 +663,7 @@ namespace sjtu {
 		 * TODO Destructors
 		 */
 		~map() {
-			_clear_recursive(_root);
+			_clear();
 		}
 
 		/**
@@ -642,7 +693,8 @@ namespace sjtu {
 		T& operator[](const Key& key) {
 			Node* nd = _root;
 			if (_locate(key, nd)) return nd->_val.second;
-			return _insert(nd, new Node(value_type(key, T()), Node::RED, nd))->_val.second;
+			return _insert(nd, _new_node(Node::RED, nd, std::in_place, std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple()))->_val.second;
 		}
 
 		/**
@@ -699,13 +751,19 @@ namespace sjtu {
 		size_t size() const {
 			return _size;
 		}
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+		/**
+		 * allocation counters of the node allocator
+		 */
+		s7a9::alloc_stats stats() const {
+			return _node_alloc.stats();
+		}
+#endif
 		/**
 		 * clears the contents
 		 */
 		void clear() {
-			_clear_recursive(_root);
-			_root = nullptr;
-			_size = 0;
+			_clear();
 		}
 		/**
 		 * insert an element.
@@ -722,7 +780,7 @@ namespace sjtu {
 				);
 			}
 			return pair<iterator, bool>(
-				iterator(_insert(nd, new Node(value, Node::RED, nd)), &_root),
+				iterator(_insert(nd, _new_node(value, Node::RED, nd)), &_root),
 				true
 			);
 		}
@@ -736,7 +794,51 @@ namespace sjtu {
 				);
 			}
 			return pair<iterator, bool>(
-				iterator(_insert(nd, new Node(value, Node::RED, nd)), &_root),
+				iterator(_insert(nd, _new_node(std::move(value), Node::RED, nd)), &_root),
+				true
+			);
+		}
+
+		/**
+		 * construct an element in place from args, unless its key already exists.
+		 * the element is built first to learn its key, and destroyed again if it is a duplicate.
+		 */
+		template <class... Args>
+		pair<iterator, bool> emplace(Args&&... args) {
+			Node* cur = _new_node(Node::RED, nullptr, std::in_place, std::forward<Args>(args)...);
+			Node* nd = _root;
+			if (_locate(cur->_val.first, nd)) {
+				_delete_node(cur);
+				return pair<iterator, bool>(iterator(nd, &_root), false);
+			}
+			cur->_fa = nd;
+			return pair<iterator, bool>(iterator(_insert(nd, cur), &_root), true);
+		}
+
+		/**
+		 * if key does not exist, insert an element whose value is constructed in place from args.
+		 * nothing is constructed when key already exists.
+		 */
+		template <class... Args>
+		pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+			Node* nd = _root;
+			if (_locate(key, nd))
+				return pair<iterator, bool>(iterator(nd, &_root), false);
+			return pair<iterator, bool>(
+				iterator(_insert(nd, _new_node(Node::RED, nd, std::in_place, std::piecewise_construct,
+					std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...))), &_root),
+				true
+			);
+		}
+
+		template <class... Args>
+		pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+			Node* nd = _root;
+			if (_locate(key, nd))
+				return pair<iterator, bool>(iterator(nd, &_root), false);
+			return pair<iterator, bool>(
+				iterator(_insert(nd, _new_node(Node::RED, nd, std::in_place, std::piecewise_construct,
+					std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...))), &_root),
 				true
 			);
 		}
@@ -0,0 +1,355 @@
+#ifndef STLITE_MAPPED_VECTOR_HPP
+#define STLITE_MAPPED_VECTOR_HPP
+
+#ifdef __linux__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "utilities.hpp"
+#include "exceptions.hpp"
+
+namespace s7a9 {
+    enum class map_mode {
+        read_only,     // shared read-only mapping; the vector cannot change
+        read_write,    // shared mapping; changes reach the file, which grows as needed
+        copy_on_write  // private mapping; changes stay in this process
+    };
+
+    // Header at the start of a mapped_vector file
+    // The elements follow at offset sizeof(mapped_header). Files are written
+    // in the byte order of the machine.
+    struct mapped_header {
+        static constexpr char MAGIC[8] = { 'S', '7', 'A', '9', 'V', 'E', 'C', '\0' };
+
+        static constexpr uint32_t VERSION = 1;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t elem_size;
+        uint64_t size;
+        uint64_t capacity;
+        uint32_t elem_align;
+        char reserved[28];
+    };
+
+    static_assert(sizeof(mapped_header) == 64, "mapped_header: the header must take 64 bytes");
+
+    // Vector of trivially copyable elements stored in a file
+    // The file is mapped as a whole, so opening it costs no parsing and pages
+    // are read on first touch; processes mapping the same file share its
+    // pages. The header records the element size, alignment and count, and a
+    // file with a different magic, version, element size or alignment is
+    // rejected. In read_write mode appending past the capacity grows the file
+    // with ftruncate() and the mapping with mremap(). In copy_on_write mode
+    // the vector first grows within the file's capacity and then moves to
+    // anonymous memory; the file is never changed. Element pointers are invalidated by growth, like
+    // vector. Errors, and changing the size of a read_only vector, throw
+    // runtime_error.
+    template <class elemType>
+    class mapped_vector {
+    private:
+        static_assert(std::is_trivially_copyable<elemType>::value,
+            "mapped_vector: elements must be trivially copyable");
+
+        static_assert(alignof(elemType) <= sizeof(mapped_header),
+            "mapped_vector: elements must not be aligned beyond the header size");
+
+        static constexpr size_t MIN_CAPACITY = 16, HEADER_BYTES = sizeof(mapped_header);
+
+        int _fd;
+
+        map_mode _mode;
+
+        bool _detached; // copy_on_write only: the mapping is anonymous memory
+
+        char* _base;
+
+        size_t _len; // Length of the mapping
+
+        inline mapped_header* _header() const noexcept {
+            return reinterpret_cast<mapped_header*>(_base);
+        }
+
+        inline elemType* _begin() const noexcept {
+            return reinterpret_cast<elemType*>(_base + HEADER_BYTES);
+        }
+
+        static inline size_t _bytes(size_t cap) noexcept {
+            return HEADER_BYTES + cap * sizeof(elemType);
+        }
+
+        inline void _check_writable() const {
+            if (_mode == map_mode::read_only) throw sjtu::runtime_error();
+        }
+
+        inline void _check(size_t idx) const {
+            if (idx >= size()) throw sjtu::index_out_of_bound();
+        }
+
+        static void _init_header(mapped_header* h, size_t cap) noexcept {
+            memset(h, 0, sizeof(mapped_header));
+            memcpy(h->magic, mapped_header::MAGIC, sizeof(h->magic));
+            h->version = mapped_header::VERSION;
+            h->elem_size = sizeof(elemType);
+            h->elem_align = alignof(elemType);
+            h->size = 0;
+            h->capacity = cap;
+        }
+
+        bool _valid_header(size_t file_len) const noexcept {
+            if (file_len < HEADER_BYTES) return false;
+            const mapped_header* h = _header();
+            return memcmp(h->magic, mapped_header::MAGIC, sizeof(h->magic)) == 0 &&
+                h->version == mapped_header::VERSION && h->elem_size == sizeof(elemType) &&
+                h->elem_align == alignof(elemType) && h->size <= h->capacity && _bytes(h->capacity) <= file_len;
+        }
+
+        void _map(size_t len) {
+            int prot = _mode == map_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+                flags = _mode == map_mode::copy_on_write ? MAP_PRIVATE : MAP_SHARED;
+            void* p = mmap(nullptr, len, prot, flags, _fd, 0);
+            if (p == MAP_FAILED) throw sjtu::runtime_error();
+            _base = static_cast<char*>(p), _len = len;
+        }
+
+        void _release() noexcept {
+            if (_base) munmap(_base, _len);
+            if (_fd >= 0) ::close(_fd);
+            _base = nullptr, _fd = -1, _len = 0;
+        }
+
+        // make room for num elements, doubling the capacity at least
+        void _grow(size_t num) {
+            size_t cap = capacity();
+            if (num <= cap) return;
+            _reallocate(val_max(val_max(num, cap * 2), MIN_CAPACITY));
+        }
+
+        void _reallocate(size_t cap) {
+            size_t len = _bytes(cap);
+            if (_mode == map_mode::copy_on_write && !_detached) {
+                void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED) throw sjtu::runtime_error();
+                memcpy(p, _base, _bytes(size()));
+                munmap(_base, _len);
+                _base = static_cast<char*>(p), _len = len, _detached = true;
+            }
+            else {
+                if (!_detached && ftruncate(_fd, static_cast<off_t>(len)) != 0) throw sjtu::runtime_error();
+                void* p = mremap(_base, _len, len, MREMAP_MAYMOVE);
+                if (p == MAP_FAILED) throw sjtu::runtime_error();
+                _base = static_cast<char*>(p), _len = len;
+            }
+            _header()->capacity = cap;
+        }
+
+    public:
+        // map the file at path; in read_write mode a missing or empty file
+        // is created with an empty vector
+        explicit mapped_vector(const char* path, map_mode mode = map_mode::read_write) :
+            _fd(-1), _mode(mode), _detached(false), _base(nullptr), _len(0) {
+            _fd = ::open(path, mode == map_mode::read_write ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+            if (_fd < 0) throw sjtu::runtime_error();
+            struct stat st;
+            if (fstat(_fd, &st) != 0) {
+                _release();
+                throw sjtu::runtime_error();
+            }
+            size_t file_len = static_cast<size_t>(st.st_size);
+            try {
+                if (file_len == 0 && mode == map_mode::read_write) {
+                    file_len = _bytes(MIN_CAPACITY);
+                    if (ftruncate(_fd, static_cast<off_t>(file_len)) != 0) throw sjtu::runtime_error();
+                    _map(file_len);
+                    _init_header(_header(), MIN_CAPACITY);
+                    return;
+                }
+                if (file_len < HEADER_BYTES) throw sjtu::runtime_error();
+                _map(file_len);
+                if (!_valid_header(file_len)) throw sjtu::runtime_error();
+            }
+            catch (...) {
+                _release();
+                throw;
+            }
+        }
+
+        mapped_vector(const mapped_vector&) = delete;
+
+        mapped_vector& operator=(const mapped_vector&) = delete;
+
+        mapped_vector(mapped_vector&& x) noexcept :
+            _fd(x._fd), _mode(x._mode), _detached(x._detached), _base(x._base), _len(x._len) {
+            x._fd = -1, x._base = nullptr, x._len = 0;
+        }
+
+        mapped_vector& operator=(mapped_vector&& rhs) noexcept {
+            if (this == &rhs) return *this;
+            _release();
+            _fd = rhs._fd, _mode = rhs._mode, _detached = rhs._detached;
+            _base = rhs._base, _len = rhs._len;
+            rhs._fd = -1, rhs._base = nullptr, rhs._len = 0;
+            return *this;
+        }
+
+        ~mapped_vector() {
+            _release();
+        }
+
+        map_mode mode() const noexcept {
+            return _mode;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        size_t size() const noexcept {
+            return _base ? static_cast<size_t>(_header()->size) : 0;
+        }
+
+        size_t capacity() const noexcept {
+            return _base ? static_cast<size_t>(_header()->capacity) : 0;
+        }
+
+        // make the capacity at least num without changing the size
+        void reserve(size_t num) {
+            _check_writable();
+            if (num > capacity()) _reallocate(num);
+        }
+
+        // zero-fill new elements or drop the ones past sz
+        void resize(size_t sz) {
+            _check_writable();
+            size_t old_size = size();
+            _grow(sz);
+            if (sz > old_size) memset(static_cast<void*>(_begin() + old_size), 0, (sz - old_size) * sizeof(elemType));
+            _header()->size = sz;
+        }
+
+        // drop every element, keeping the capacity
+        void clear() {
+            _check_writable();
+            _header()->size = 0;
+        }
+
+        // the pages of a read_only vector are not writable, so writing through
+        // the returned reference faults
+        elemType& operator[](size_t idx) {
+            _check(idx);
+            return _begin()[idx];
+        }
+
+        const elemType& operator[](size_t idx) const {
+            _check(idx);
+            return _begin()[idx];
+        }
+
+        elemType& at(size_t idx) {
+            return (*this)[idx];
+        }
+
+        const elemType& at(size_t idx) const {
+            return (*this)[idx];
+        }
+
+        elemType& front() {
+            if (empty()) throw sjtu::container_is_empty();
+            return (*this)[0];
+        }
+
+        const elemType& front() const {
+            if (empty()) throw sjtu::container_is_empty();
+            return (*this)[0];
+        }
+
+        elemType& back() {
+            if (empty()) throw sjtu::container_is_empty();
+            return (*this)[size() - 1];
+        }
+
+        const elemType& back() const {
+            if (empty()) throw sjtu::container_is_empty();
+            return (*this)[size() - 1];
+        }
+
+        elemType* data() noexcept {
+            return _begin();
+        }
+
+        const elemType* data() const noexcept {
+            return _begin();
+        }
+
+        elemType* begin() noexcept {
+            return _begin();
+        }
+
+        const elemType* begin() const noexcept {
+            return _begin();
+        }
+
+        const elemType* cbegin() const noexcept {
+            return _begin();
+        }
+
+        elemType* end() noexcept {
+            return _begin() + size();
+        }
+
+        const elemType* end() const noexcept {
+            return _begin() + size();
+        }
+
+        const elemType* cend() const noexcept {
+            return _begin() + size();
+        }
+
+        void push_back(const elemType& x) {
+            _check_writable();
+            size_t sz = size();
+            _grow(sz + 1);
+            _begin()[sz] = x;
+            _header()->size = sz + 1;
+        }
+
+        // append n elements from first with a single copy
+        void append(const elemType* first, size_t n) {
+            _check_writable();
+            size_t sz = size();
+            _grow(sz + n);
+            if (n) memcpy(static_cast<void*>(_begin() + sz), first, n * sizeof(elemType));
+            _header()->size = sz + n;
+        }
+
+        void pop_back() {
+            _check_writable();
+            if (empty()) throw sjtu::container_is_empty();
+            --_header()->size;
+        }
+
+        // write dirty pages back to the file; only read_write has any
+        void sync() {
+            if (_mode == map_mode::read_write && _base && msync(_base, _len, MS_SYNC) != 0)
+                throw sjtu::runtime_error();
+        }
+
+        void swap(mapped_vector& x) noexcept {
+            s7a9::swap(_fd, x._fd);
+            s7a9::swap(_mode, x._mode);
+            s7a9::swap(_detached, x._detached);
+            s7a9::swap(_base, x._base);
+            s7a9::swap(_len, x._len);
+        }
+    };
+}
+
+#endif // __linux__
+
+#endif // STLITE_MAPPED_VECTOR_HPP
@@ -0,0 +1,277 @@
+#ifndef STLITE_MPMC_QUEUE_HPP
+#define STLITE_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "allocator.hpp"
+#include "exceptions.hpp"
+
+namespace s7a9 {
+    // Bounded multi-producer/multi-consumer queue
+    // Each slot carries a sequence number (D. Vyukov's bounded MPMC queue):
+    // a producer claims position p with a compare-and-swap once slot p says
+    // p, and marks it p + 1 when the element is built; a consumer claims it
+    // once the slot says p + 1, and marks it p + capacity for the next lap.
+    // Producers and consumers only contend on their own counter, and a slot is
+    // never touched by two threads at once. try_push()/try_pop() never block.
+    // push()/pop() spin for a while and then sleep on a futex (a yield loop
+    // elsewhere) until the queue changes; a waker only makes the system call
+    // when a thread is actually asleep.
+    template <class elemType>
+    class mpmc_queue {
+    private:
+        // A claimed slot must always end up holding an element, so elements
+        // are built before a slot is claimed and then moved in
+        static_assert(std::is_nothrow_move_constructible<elemType>::value,
+            "mpmc_queue: the element type must be nothrow move constructible");
+
+        static constexpr size_t SPIN = 128;
+
+        struct cell_t {
+            std::atomic<size_t> seq;
+            alignas(elemType) unsigned char buf[sizeof(elemType)];
+
+            inline elemType* elem() noexcept {
+                return reinterpret_cast<elemType*>(buf);
+            }
+        };
+
+        cell_t* _cells;
+
+        size_t _mask;
+
+        cache_padded<std::atomic<size_t>> _enqueue; // Next position to claim for a push
+
+        cache_padded<std::atomic<size_t>> _dequeue; // Next position to claim for a pop
+
+        // Event counters bumped when an element arrives or a slot frees up,
+        // and the number of threads sleeping on each
+        cache_padded<std::atomic<uint32_t>> _pushed, _popped;
+
+        cache_padded<std::atomic<uint32_t>> _pop_waiters, _push_waiters;
+
+        // Largest power-of-two capacity whose slots fit in size_t bytes
+        static constexpr size_t MAX_CAPACITY = size_t(1) << log2_floor(size_t(-1) / sizeof(cell_t));
+
+        static inline size_t _round_up(size_t num) {
+            if (num > MAX_CAPACITY) throw sjtu::runtime_error();
+            size_t ret = 2;
+            while (ret < num) ret <<= 1;
+            return ret;
+        }
+
+        static inline void _relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+
+        // sleep while *addr still holds val
+        static inline void _wait(std::atomic<uint32_t>& addr, uint32_t val) noexcept {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&addr), FUTEX_WAIT_PRIVATE, val, nullptr, nullptr, 0);
+#else
+            while (addr.load(std::memory_order_acquire) == val) std::this_thread::yield();
+#endif
+        }
+
+        // bump the event counter and wake one sleeper, if there is any
+        static inline void _notify(std::atomic<uint32_t>& event, std::atomic<uint32_t>& waiters) noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters.load(std::memory_order_relaxed) == 0) return;
+            event.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&event), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+        }
+
+        // run attempt() until it succeeds: spin first, then sleep on event
+        template <class Attempt>
+        static void _block(Attempt attempt, std::atomic<uint32_t>& event, std::atomic<uint32_t>& waiters) {
+            for (size_t i = 0; i < SPIN; ++i) {
+                if (attempt()) return;
+                _relax();
+            }
+            while (true) {
+                uint32_t ev = event.load(std::memory_order_acquire);
+                if (attempt()) return;
+                waiters.fetch_add(1, std::memory_order_seq_cst);
+                if (attempt()) {
+                    waiters.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+                _wait(event, ev);
+                waiters.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // claim a slot for a push, or nullptr if the queue is full
+        cell_t* _claim_push(size_t& pos) noexcept {
+            pos = _enqueue->load(std::memory_order_relaxed);
+            while (true) {
+                cell_t* cell = _cells + (pos & _mask);
+                intptr_t dif = intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos);
+                if (dif == 0) {
+                    if (_enqueue->compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return cell;
+                }
+                else if (dif < 0) return nullptr;
+                else pos = _enqueue->load(std::memory_order_relaxed);
+            }
+        }
+
+        // claim an element for a pop, or nullptr if the queue is empty
+        cell_t* _claim_pop(size_t& pos) noexcept {
+            pos = _dequeue->load(std::memory_order_relaxed);
+            while (true) {
+                cell_t* cell = _cells + (pos & _mask);
+                intptr_t dif = intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos + 1);
+                if (dif == 0) {
+                    if (_dequeue->compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return cell;
+                }
+                else if (dif < 0) return nullptr;
+                else pos = _dequeue->load(std::memory_order_relaxed);
+            }
+        }
+
+        // hand a filled slot to the consumers
+        inline void _publish(cell_t* cell, size_t pos) noexcept {
+            cell->seq.store(pos + 1, std::memory_order_release);
+            _notify(*_pushed, *_pop_waiters);
+        }
+
+        // destroy the element of a popped slot and hand the slot to the producers
+        inline void _release(cell_t* cell, size_t pos) noexcept {
+            cell->elem()->~elemType();
+            cell->seq.store(pos + _mask + 1, std::memory_order_release);
+            _notify(*_popped, *_push_waiters);
+        }
+
+    public:
+        explicit mpmc_queue(size_t capacity) {
+            size_t num = _round_up(capacity);
+            _cells = static_cast<cell_t*>(::operator new(num * sizeof(cell_t), std::align_val_t(alignof(cell_t))));
+            for (size_t i = 0; i < num; ++i)
+                new(&_cells[i].seq) std::atomic<size_t>(i);
+            _mask = num - 1;
+            _enqueue->store(0, std::memory_order_relaxed);
+            _dequeue->store(0, std::memory_order_relaxed);
+            _pushed->store(0, std::memory_order_relaxed);
+            _popped->store(0, std::memory_order_relaxed);
+            _pop_waiters->store(0, std::memory_order_relaxed);
+            _push_waiters->store(0, std::memory_order_relaxed);
+        }
+
+        mpmc_queue(const mpmc_queue&) = delete;
+
+        mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+        // no thread may still be using the queue
+        ~mpmc_queue() {
+            size_t pos = _dequeue->load(std::memory_order_relaxed), last = _enqueue->load(std::memory_order_relaxed);
+            for (; pos != last; ++pos)
+                _cells[pos & _mask].elem()->~elemType();
+            ::operator delete(_cells, std::align_val_t(alignof(cell_t)));
+        }
+
+        size_t capacity() const noexcept {
+            return _mask + 1;
+        }
+
+        // number of queued elements; only a snapshot while other threads run
+        size_t size() const noexcept {
+            size_t head = _dequeue->load(std::memory_order_acquire), tail = _enqueue->load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        // construct an element from args, or return false if the queue is full;
+        // a constructor that may throw runs before a slot is claimed
+        template <class... Args>
+        bool try_emplace(Args&&... args) {
+            if constexpr (std::is_nothrow_constructible<elemType, Args&&...>::value) {
+                size_t pos;
+                cell_t* cell = _claim_push(pos);
+                if (cell == nullptr) return false;
+                new(cell->elem()) elemType(Forward<Args>(args)...);
+                _publish(cell, pos);
+                return true;
+            }
+            else {
+                elemType x(Forward<Args>(args)...);
+                size_t pos;
+                cell_t* cell = _claim_push(pos);
+                if (cell == nullptr) return false;
+                new(cell->elem()) elemType(Move(x));
+                _publish(cell, pos);
+                return true;
+            }
+        }
+
+        bool try_push(const elemType& x) {
+            return try_emplace(x);
+        }
+
+        bool try_push(elemType&& x) {
+            return try_emplace(Move(x));
+        }
+
+        // move the oldest element into out, or return false if the queue is empty;
+        // if a throwing move assignment fails, the element is gone but the
+        // queue stays usable
+        bool try_pop(elemType& out) {
+            size_t pos;
+            cell_t* cell = _claim_pop(pos);
+            if (cell == nullptr) return false;
+            if constexpr (std::is_nothrow_move_assignable<elemType>::value) {
+                out = Move(*cell->elem());
+                _release(cell, pos);
+            }
+            else {
+                elemType x(Move(*cell->elem()));
+                _release(cell, pos);
+                out = Move(x);
+            }
+            return true;
+        }
+
+        // push x, waiting while the queue is full; a copy that may throw is
+        // made once up front rather than on every attempt
+        void push(const elemType& x) {
+            if constexpr (std::is_nothrow_copy_constructible<elemType>::value)
+                _block([this, &x]() { return try_emplace(x); }, *_popped, *_push_waiters);
+            else
+                push(elemType(x));
+        }
+
+        void push(elemType&& x) {
+            _block([this, &x]() { return try_emplace(Move(x)); }, *_popped, *_push_waiters);
+        }
+
+        // pop into out, waiting while the queue is empty
+        void pop(elemType& out) {
+            _block([this, &out]() { return try_pop(out); }, *_pushed, *_pop_waiters);
+        }
+
+        elemType pop() {
+            elemType ret;
+            pop(ret);
+            return ret;
+        }
+    };
+}
+
+#endif // STLITE_MPMC_QUEUE_HPP
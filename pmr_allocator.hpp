@@ -0,0 +1,123 @@
+#ifndef STLITE_PMR_ALLOCATOR_HPP
+#define STLITE_PMR_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include "utilities.hpp"
+#include "allocator.hpp"
+
+namespace s7a9 {
+    // Memory policy: blocks from a std::pmr::memory_resource
+    // The resource is shared, not owned: copies draw from the same resource,
+    // which must outlive every container using it.
+    class __pmr_memory {
+    private:
+        static constexpr size_t ALIGN = alignof(std::max_align_t);
+
+        std::pmr::memory_resource* _res;
+
+    public:
+        __pmr_memory(std::pmr::memory_resource* res = std::pmr::get_default_resource()) noexcept :
+            _res(res) {}
+
+        inline std::pmr::memory_resource* resource() const noexcept {
+            return _res;
+        }
+
+        inline void* allocate(size_t bytes) noexcept {
+            try {
+                return _res->allocate(bytes, ALIGN);
+            }
+            catch (...) {
+                return nullptr;
+            }
+        }
+
+        // resources cannot grow a block, so it is always copied
+        void* reallocate(void* p, size_t old_bytes, size_t bytes) noexcept {
+            void* ret = allocate(bytes);
+            if (ret && p) {
+                memcpy(ret, p, val_min(old_bytes, bytes));
+                deallocate(p, old_bytes);
+            }
+            return ret;
+        }
+
+        inline bool resize_in_place(void*, size_t old_bytes, size_t bytes) noexcept {
+            return old_bytes == bytes;
+        }
+
+        inline void deallocate(void* p, size_t bytes) noexcept {
+            if (p) _res->deallocate(p, bytes, ALIGN);
+        }
+
+        inline void swap(__pmr_memory& other) noexcept {
+            s7a9::swap(_res, other._res);
+        }
+    };
+
+    // Slot allocator over a memory resource, e.g.
+    // vector<int, __pmr_allocator<int>> v(&pool);
+    template <class elemType>
+    using __pmr_allocator = __slot_allocator<elemType, __pmr_memory>;
+
+    // Node allocator: one node at a time from a std::pmr::memory_resource
+    // Like __pmr_memory the resource is shared by copies. Nodes can only be
+    // spliced between containers drawing from the same resource.
+    template <class nodeType>
+    class __pmr_node_allocator {
+    private:
+        std::pmr::memory_resource* _res;
+
+        STLITE_STATS(__stats_counter _counter{ "pmr_node_allocator" };)
+
+    public:
+        __pmr_node_allocator(std::pmr::memory_resource* res = std::pmr::get_default_resource()) noexcept :
+            _res(res) {}
+
+        __pmr_node_allocator(const __pmr_node_allocator& x) noexcept :
+            _res(x._res) {}
+
+        __pmr_node_allocator(__pmr_node_allocator&& x) noexcept :
+            _res(x._res) {
+            STLITE_STATS(_counter.swap(x._counter);)
+        }
+
+        inline std::pmr::memory_resource* resource() const noexcept {
+            return _res;
+        }
+
+        inline nodeType* allocate() {
+            void* p = _res->allocate(sizeof(nodeType), alignof(nodeType));
+            STLITE_STATS(_counter.on_alloc(sizeof(nodeType));)
+            return static_cast<nodeType*>(p);
+        }
+
+        inline void deallocate(nodeType* p) noexcept {
+            STLITE_STATS(_counter.on_free(sizeof(nodeType));)
+            _res->deallocate(p, sizeof(nodeType), alignof(nodeType));
+        }
+
+        // every node has been deallocated one by one, nothing left to do
+        inline void release() noexcept {}
+
+        // the nodes of other stay with the shared resource, only the counts move
+        inline void merge(__pmr_node_allocator& other) noexcept {
+            STLITE_STATS(if (this != &other) _counter.merge(other._counter);)
+        }
+
+        inline void swap(__pmr_node_allocator& other) noexcept {
+            s7a9::swap(_res, other._res);
+            STLITE_STATS(_counter.swap(other._counter);)
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
+        }
+#endif
+    };
+}
+
+#endif // STLITE_PMR_ALLOCATOR_HPP
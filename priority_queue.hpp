@@ -5,13 +5,14 @@
 #include <cstddef>
 #include <functional>
 #include "exceptions.hpp"
+#include "allocator.hpp"
 
 namespace sjtu {
 
 	/**
 	 * a container like std::priority_queue which is a heap internal.
 	 */
-	template<typename T, class Compare>
+	template<typename T, class Compare, template <class> class NodeAllocator = s7a9::__pool_allocator>
 	class __binary_heap {
 	private:
 		struct node_t {
@@ -26,7 +27,7 @@ namespace sjtu {
 				son = fa = nxt = nullptr;
 			}
 
-			node_t(T&& val) : val(val) {
+			node_t(T&& val) : val(std::move(val)) {
 				degree = 0;
 				son = fa = nxt = nullptr;
 			}
@@ -36,6 +37,26 @@ namespace sjtu {
 
 		size_t _size;
 
+		NodeAllocator<node_t> _node_alloc;
+
+		template <class... Args>
+		node_t* _new_node(Args&&... args) {
+			node_t* nd = _node_alloc.allocate();
+			try {
+				new(nd) node_t(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				_node_alloc.deallocate(nd);
+				throw;
+			}
+			return nd;
+		}
+
+		inline void _delete_node(node_t* nd) noexcept {
+			nd->~node_t();
+			_node_alloc.deallocate(nd);
+		}
+
 		static node_t* _merge(node_t* head1, node_t* head2) {
 			static Compare _comp;
 			node_t* head = nullptr, * cur = nullptr, * fa = nullptr, * son = nullptr, * lst = nullptr;
@@ -88,20 +109,29 @@ namespace sjtu {
 			return head;
 		}
 
-		static node_t* _copy_recursive(const node_t* node, node_t* fa) {
+		node_t* _copy_recursive(const node_t* node, node_t* fa) {
 			if (node == nullptr) return nullptr;
-			node_t* ret = new node_t(node->val);
+			node_t* ret = _new_node(node->val);
 			ret->fa = fa, ret->degree = node->degree;
 			if (node->son) ret->son = _copy_recursive(node->son, ret);
 			if (node->nxt) ret->nxt = _copy_recursive(node->nxt, fa);
 			return ret;
 		}
 
-		static void _clear_recursive(node_t* node) {
+		void _clear_recursive(node_t* node) {
 			if (node == nullptr) return;
 			if (node->son) _clear_recursive(node->son);
 			if (node->nxt) _clear_recursive(node->nxt);
-			delete node;
+			_delete_node(node);
+		}
+
+		// destroy all nodes and hand their memory back at once
+		inline void _clear() {
+			if (!s7a9::__skip_destroy<NodeAllocator<node_t>, node_t>::value)
+				_clear_recursive(_head);
+			_node_alloc.release();
+			_head = _ptop = nullptr;
+			_size = 0;
 		}
 
 		inline void _update_top() {
@@ -132,7 +162,8 @@ namespace sjtu {
 		}
 
 		__binary_heap(__binary_heap&& other) : 
-			_size(other._size), _head(other._head), _ptop(other._ptop) {
+			_head(other._head), _ptop(other._ptop), _size(other._size),
+			_node_alloc(std::move(other._node_alloc)) {
 			other._size = 0;
 			other._head = other._ptop = nullptr;
 		}
@@ -140,14 +171,14 @@ namespace sjtu {
 		 * TODO deconstructor
 		 */
 		inline ~__binary_heap() {
-			_clear_recursive(_head);
+			_clear();
 		}
 		/**
 		 * TODO Assignment operator
 		 */
 		__binary_heap& operator=(const __binary_heap& other) {
 			if (this == &other) return *this;
-			_clear_recursive(_head);
+			_clear();
 			_size = other._size;
 			_head = _copy_recursive(other._head, nullptr);
 			_update_top();
@@ -167,13 +198,13 @@ namespace sjtu {
 		 * push new element to the priority queue.
 		 */
 		inline void push(const T& e) {
-			_head = _merge(_head, new node_t(e));
+			_head = _merge(_head, _new_node(e));
 			_update_top();
 			++_size;
 		}
 
 		inline void push(T&& e) {
-			_head = _merge(_head, new node_t(e));
+			_head = _merge(_head, _new_node(std::move(e)));
 			_update_top();
 			++_size;
 		}
@@ -203,7 +234,7 @@ namespace sjtu {
 				son_lst = son_cur;
 			}
 			_head = _merge(_head, son_lst);
-			delete _ptop;
+			_delete_node(_ptop);
 			_update_top();
 			--_size;
 		}
@@ -213,6 +244,14 @@ namespace sjtu {
 		inline size_t size() const {
 			return _size;
 		}
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+		/**
+		 * allocation counters of the node allocator
+		 */
+		s7a9::alloc_stats stats() const {
+			return _node_alloc.stats();
+		}
+#endif
 		/**
 		 * check if the container has at least an element.
 		 * @return true if it is empty, false if it has at least an element.
@@ -225,6 +264,7 @@ namespace sjtu {
 		 * clear the other priority_queue.
 		 */
 		void merge(__binary_heap& other) {
+			_node_alloc.merge(other._node_alloc);
 			_head = _merge(_head, other._head);
 			_update_top();
 			other._head = other._ptop = nullptr;
@@ -233,8 +273,11 @@ namespace sjtu {
 	};
 
 
-	template<typename T, class Compare = std::less<T>>
-	using priority_queue = __binary_heap<T, Compare>;
+	template<
+		typename T,
+		class Compare = std::less<T>,
+		template <class> class NodeAllocator = s7a9::__pool_allocator
+	> using priority_queue = __binary_heap<T, Compare, NodeAllocator>;
 
 }
 
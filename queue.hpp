@@ -7,25 +7,26 @@
 
 namespace s7a9 {
 
-	template <typename T, class Compare = std::less<T>>
-	class priority_queue {
+	template <
+		typename T,
+		class Compare = std::less<T>,
+		template <class> class NodeAllocator = __pool_allocator
+	> class priority_queue {
 	private:
+		// the value lives inside the node, so one push costs one allocation
 		struct node_t {
-			T* pval;
+			T val;
 			size_t dis;
 			node_t* ls, * rs;
 
-			node_t(T* pval, size_t dis) :
-				pval(pval), dis(dis) {
+			node_t(const T& val, size_t dis) :
+				val(val), dis(dis) {
 				ls = rs = nullptr;
 			}
 
-			inline void del_subtree() {
-				if (ls) ls->del_subtree();
-				if (rs) rs->del_subtree();
-				delete ls;
-				delete rs;
-				delete pval;
+			node_t(T&& val, size_t dis) :
+				val(Move(val)), dis(dis) {
+				ls = rs = nullptr;
 			}
 		};
 
@@ -33,13 +34,39 @@ namespace s7a9 {
 
 		size_t _size;
 
+		NodeAllocator<node_t> _node_alloc;
+
+		template <class... Args>
+		node_t* _new_node(Args&&... args) {
+			node_t* nd = _node_alloc.allocate();
+			try {
+				new(nd) node_t(Forward<Args>(args)...);
+			}
+			catch (...) {
+				_node_alloc.deallocate(nd);
+				throw;
+			}
+			return nd;
+		}
+
+		inline void _delete_node(node_t* nd) noexcept {
+			nd->~node_t();
+			_node_alloc.deallocate(nd);
+		}
+
+		void _del_subtree(node_t* nd) {
+			if (nd->ls) _del_subtree(nd->ls);
+			if (nd->rs) _del_subtree(nd->rs);
+			_delete_node(nd);
+		}
+
 		//static Compare _compare;
 
 		static node_t* _merge(node_t* a, node_t* b) {
 			static Compare comp;
 			if (a == nullptr) return b;
 			if (b == nullptr) return a;
-			if (comp(*a->pval, *b->pval)) s7a9::swap(a, b);
+			if (comp(a->val, b->val)) s7a9::swap(a, b);
 			a->rs = _merge(a->rs, b);
 			if (a->ls == nullptr || a->ls->dis < a->rs->dis) {
 				s7a9::swap(a->ls, a->rs);
@@ -54,15 +81,18 @@ namespace s7a9 {
 		}
 
 		inline node_t* _copy_subtree(const node_t* node) {
-			node_t* nd = new node_t(new T(*node->pval), node->dis);
+			if (node == nullptr) return nullptr;
+			node_t* nd = _new_node(node->val, node->dis);
 			if (node->ls) nd->ls = _copy_subtree(node->ls);
 			if (node->rs) nd->rs = _copy_subtree(node->rs);
 			return nd;
 		}
 
 		inline void _clean() {
-			_root->del_subtree();
-			delete _root;
+			if (_root && !__skip_destroy<NodeAllocator<node_t>, node_t>::value)
+				_del_subtree(_root);
+			_node_alloc.release();
+			_root = nullptr;
 			_size = 0;
 		}
 
@@ -78,12 +108,13 @@ namespace s7a9 {
 		}
 
 		priority_queue(priority_queue&& other) noexcept :
-			_size(other._size), _root(other._root)  {
+			_root(other._root), _size(other._size),
+			_node_alloc(Move(other._node_alloc)) {
 			other._size = 0, other._root = nullptr;
 		}
 
 		~priority_queue() {
-			if (_root) _clean();
+			_clean();
 		}
 
 		priority_queue& operator=(const priority_queue& other) {
@@ -96,22 +127,33 @@ namespace s7a9 {
 
 		const T& top() const {
 			if (empty()) throw sjtu::container_is_empty();
-			return *(_root->pval);
+			return _root->val;
 		}
 
 		T& top() {
 			if (empty()) throw sjtu::container_is_empty();
-			return *(_root->pval);
+			return _root->val;
 		}
 
 		void push(const T& e) {
-			node_t* pn = new node_t(new T(e), 0);
+			node_t* pn = _new_node(e, 0);
 			try {
 				_root = _merge(_root, pn);
 			}
 			catch (...) {
-				delete pn->pval;
-				delete pn;
+				_delete_node(pn);
+				return;
+			}
+			++_size;
+		}
+
+		void push(T&& e) {
+			node_t* pn = _new_node(Move(e), 0);
+			try {
+				_root = _merge(_root, pn);
+			}
+			catch (...) {
+				_delete_node(pn);
 				return;
 			}
 			++_size;
@@ -120,8 +162,7 @@ namespace s7a9 {
 		void pop() {
 			node_t* old_root = _root;
 			_root = _merge(_root->ls, _root->rs);
-			delete old_root->pval;
-			delete old_root;
+			_delete_node(old_root);
 			--_size;
 		}
 
@@ -129,6 +170,13 @@ namespace s7a9 {
 			return _size;
 		}
 
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+		// allocation counters of the node allocator
+		alloc_stats stats() const {
+			return _node_alloc.stats();
+		}
+#endif
+
 		[[nodiscard]] bool empty() const noexcept {
 			return _size == 0;
 		}
@@ -139,7 +187,8 @@ namespace s7a9 {
 		}
 
 		void merge(priority_queue&& other) {
-			_root, _merge(_root, other._root);
+			_node_alloc.merge(other._node_alloc);
+			_root = _merge(_root, other._root);
 			_size += other._size;
 			other._root = nullptr;
 			other._size = 0;
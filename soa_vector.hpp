@@ -0,0 +1,580 @@
+#ifndef STLITE_SOA_VECTOR_HPP
+#define STLITE_SOA_VECTOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <utility>
+#include "allocator.hpp"
+#include "exceptions.hpp"
+#include "vector.hpp"
+
+namespace s7a9 {
+    // View of one column of a soa_vector
+    template <class T>
+    using column_span = span<T>;
+
+    // Struct-of-arrays vector
+    // Row i is (column<0>()[i], column<1>()[i], ...): every field has its own
+    // contiguous block from Allocator<Field>, so a scan over one column reads
+    // only that column. All columns share one size and one capacity, which
+    // follow the capacity policy of vector. Rows are accessed through the
+    // proxy types reference and const_reference; value_type is
+    // std::tuple<Fields...>.
+    template <template <class> class Allocator, class... Fields>
+    class basic_soa_vector {
+    public:
+        typedef std::tuple<Fields...> value_type;
+
+        static constexpr size_t FIELDS = sizeof...(Fields);
+
+        template <size_t I>
+        using field_type = std::tuple_element_t<I, value_type>;
+
+    private:
+        static constexpr size_t MIN_CAPACITY = 10,
+            GROWTH_NUM = VECTOR_GROWTH_NUM, GROWTH_DEN = VECTOR_GROWTH_DEN;
+
+        typedef std::index_sequence_for<Fields...> _indices;
+
+        static_assert(FIELDS > 0, "soa_vector: at least one field is required");
+
+        static_assert((__is_contiguous<Allocator<Fields>>::value && ...),
+            "soa_vector: the allocator must store slots contiguously");
+
+        std::tuple<Allocator<Fields>...> _columns;
+
+        size_t _size;
+
+        template <size_t I>
+        inline auto& _column() noexcept {
+            return std::get<I>(_columns);
+        }
+
+        template <size_t I>
+        inline const auto& _column() const noexcept {
+            return std::get<I>(_columns);
+        }
+
+        template <class Func, size_t... I>
+        inline void _for_columns(Func&& func, std::index_sequence<I...>) {
+            (func(std::get<I>(_columns)), ...);
+        }
+
+        // call func(column) for every column
+        template <class Func>
+        inline void _for_columns(Func&& func) {
+            _for_columns(func, _indices());
+        }
+
+        // resize every column to num rows; if a column runs out of memory while
+        // growing, the columns grown so far go back to the old capacity and
+        // bad_alloc is thrown, while a failed shrink just keeps the old blocks
+        template <size_t... I>
+        void _reallocate(size_t num, std::index_sequence<I...>) {
+            size_t cap = capacity(), done = 0;
+            if (((std::get<I>(_columns).reallocate(num) != nullptr && (++done, true)) && ...) || num < cap)
+                return;
+            ((I < done ? void(std::get<I>(_columns).reallocate(cap)) : void()), ...);
+            throw std::bad_alloc();
+        }
+
+        inline void _reallocate(size_t num) {
+            _reallocate(num, _indices());
+        }
+
+        // make room for num rows, growing by the growth factor at least
+        inline void _grow(size_t num) {
+            size_t cap = capacity();
+            if (num <= cap) return;
+            _reallocate(val_max(val_max(num, cap / GROWTH_DEN * GROWTH_NUM), MIN_CAPACITY));
+        }
+
+        // give memory back once the vector is well below its capacity
+        inline void _shrink() {
+            size_t cap = capacity();
+            if (cap > MIN_CAPACITY && _size * GROWTH_NUM * GROWTH_NUM < cap * GROWTH_DEN * GROWTH_DEN)
+                _reallocate(val_max(cap / GROWTH_NUM * GROWTH_DEN, MIN_CAPACITY));
+        }
+
+        // construct row idx field by field; on an exception the fields built
+        // so far are destroyed again
+        template <size_t... I, class... Args>
+        void _construct(std::index_sequence<I...>, size_t idx, Args&&... args) {
+            size_t done = 0;
+            try {
+                ((std::get<I>(_columns).emplace(idx, Forward<Args>(args)), ++done), ...);
+            }
+            catch (...) {
+                ((I < done ? std::get<I>(_columns).remove(idx) : void()), ...);
+                throw;
+            }
+        }
+
+        template <size_t... I>
+        inline void _construct_value(std::index_sequence<I...> seq, size_t idx, const value_type& x) {
+            _construct(seq, idx, std::get<I>(x)...);
+        }
+
+        template <size_t... I>
+        inline void _construct_value(std::index_sequence<I...> seq, size_t idx, value_type&& x) {
+            _construct(seq, idx, Move(std::get<I>(x))...);
+        }
+
+        inline void _remove(size_t idx) {
+            _for_columns([idx](auto& col) { col.remove(idx); });
+        }
+
+        template <size_t... I>
+        inline value_type _value(std::index_sequence<I...>, size_t idx) const {
+            return value_type(*std::get<I>(_columns)[idx]...);
+        }
+
+        template <size_t... I>
+        inline void _assign(std::index_sequence<I...>, size_t idx, const value_type& x) {
+            ((*std::get<I>(_columns)[idx] = std::get<I>(x)), ...);
+        }
+
+        inline void _check(size_t idx) const {
+            if (idx >= _size) throw sjtu::index_out_of_bound();
+        }
+
+    public:
+        // Row proxy: get<I>() is a reference into column I
+        class reference {
+        private:
+            basic_soa_vector* _v;
+
+            size_t _idx;
+
+            friend class basic_soa_vector;
+
+            reference(basic_soa_vector* v, size_t idx) noexcept :
+                _v(v), _idx(idx) {}
+
+        public:
+            template <size_t I>
+            inline field_type<I>& get() const noexcept {
+                return *_v->template _column<I>()[_idx];
+            }
+
+            inline operator value_type() const {
+                return _v->_value(_indices(), _idx);
+            }
+
+            inline reference& operator=(const value_type& x) {
+                _v->_assign(_indices(), _idx, x);
+                return *this;
+            }
+
+            inline reference& operator=(const reference& rhs) {
+                return *this = value_type(rhs);
+            }
+        };
+
+        class const_reference {
+        private:
+            const basic_soa_vector* _v;
+
+            size_t _idx;
+
+            friend class basic_soa_vector;
+
+            const_reference(const basic_soa_vector* v, size_t idx) noexcept :
+                _v(v), _idx(idx) {}
+
+        public:
+            const_reference(const reference& x) noexcept :
+                _v(x._v), _idx(x._idx) {}
+
+            template <size_t I>
+            inline const field_type<I>& get() const noexcept {
+                return *_v->template _column<I>()[_idx];
+            }
+
+            inline operator value_type() const {
+                return _v->_value(_indices(), _idx);
+            }
+        };
+
+    private:
+        // whether Args is one whole row, which push_back(const value_type&) and
+        // push_back(value_type&&) take even when there is a single field
+        template <class... Args>
+        struct _is_row : std::false_type {};
+
+        template <class Arg>
+        struct _is_row<Arg> : std::integral_constant<bool,
+            std::is_same<std::decay_t<Arg>, value_type>::value ||
+            std::is_same<std::decay_t<Arg>, reference>::value ||
+            std::is_same<std::decay_t<Arg>, const_reference>::value> {};
+
+    public:
+        // Random access iterator over rows, yielding row proxies
+        template <bool Const>
+        class row_iterator {
+        private:
+            typedef std::conditional_t<Const, const basic_soa_vector*, basic_soa_vector*> owner_t;
+
+            owner_t _v;
+
+            size_t _idx;
+
+            friend class basic_soa_vector;
+
+            template <bool> friend class row_iterator;
+
+            row_iterator(owner_t v, size_t idx) noexcept :
+                _v(v), _idx(idx) {}
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef typename basic_soa_vector::value_type value_type;
+            typedef ptrdiff_t difference_type;
+            typedef void pointer;
+            typedef std::conditional_t<Const, const_reference, typename basic_soa_vector::reference> reference;
+
+            row_iterator() noexcept : _v(nullptr), _idx(0) {}
+
+            template <bool C, class = std::enable_if_t<Const && !C>>
+            row_iterator(const row_iterator<C>& iter) noexcept :
+                _v(iter._v), _idx(iter._idx) {}
+
+            inline reference operator*() const noexcept {
+                return reference(_v, _idx);
+            }
+
+            inline reference operator[](ptrdiff_t offset) const noexcept {
+                return reference(_v, _idx + offset);
+            }
+
+            inline row_iterator& operator++() noexcept {
+                ++_idx;
+                return *this;
+            }
+
+            inline row_iterator operator++(int) noexcept {
+                row_iterator iter(*this);
+                ++_idx;
+                return iter;
+            }
+
+            inline row_iterator& operator--() noexcept {
+                --_idx;
+                return *this;
+            }
+
+            inline row_iterator operator--(int) noexcept {
+                row_iterator iter(*this);
+                --_idx;
+                return iter;
+            }
+
+            inline row_iterator& operator+=(ptrdiff_t offset) noexcept {
+                _idx += offset;
+                return *this;
+            }
+
+            inline row_iterator& operator-=(ptrdiff_t offset) noexcept {
+                _idx -= offset;
+                return *this;
+            }
+
+            inline row_iterator operator+(ptrdiff_t offset) const noexcept {
+                return row_iterator(_v, _idx + offset);
+            }
+
+            inline row_iterator operator-(ptrdiff_t offset) const noexcept {
+                return row_iterator(_v, _idx - offset);
+            }
+
+            friend inline row_iterator operator+(ptrdiff_t offset, const row_iterator& iter) noexcept {
+                return iter + offset;
+            }
+
+            friend inline ptrdiff_t operator-(const row_iterator& lhs, const row_iterator& rhs) noexcept {
+                return ptrdiff_t(lhs._idx) - ptrdiff_t(rhs._idx);
+            }
+
+            inline bool operator==(const row_iterator& rhs) const noexcept {
+                return _v == rhs._v && _idx == rhs._idx;
+            }
+
+            inline bool operator!=(const row_iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            inline bool operator<(const row_iterator& rhs) const noexcept {
+                return _idx < rhs._idx;
+            }
+
+            inline bool operator>(const row_iterator& rhs) const noexcept {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const row_iterator& rhs) const noexcept {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const row_iterator& rhs) const noexcept {
+                return !(*this < rhs);
+            }
+        };
+
+        typedef row_iterator<false> iterator;
+
+        typedef row_iterator<true> const_iterator;
+
+        basic_soa_vector() :
+            _columns(Allocator<Fields>(MIN_CAPACITY)...), _size(0) {}
+
+        basic_soa_vector(const basic_soa_vector& x) :
+            _columns(x._columns), _size(x._size) {}
+
+        basic_soa_vector(basic_soa_vector&& x) noexcept :
+            _columns(Move(x._columns)), _size(x._size) {
+            x._size = 0;
+        }
+
+        basic_soa_vector& operator=(const basic_soa_vector& rhs) {
+            if (this == &rhs) return *this;
+            _for_columns_with(rhs, [](auto& col, const auto& other) { col.copy(other); }, _indices());
+            _size = rhs._size;
+            return *this;
+        }
+
+        basic_soa_vector& operator=(basic_soa_vector&& rhs) {
+            if (this == &rhs) return *this;
+            _for_columns([](auto& col) { col.clean(); });
+            swap(rhs);
+            rhs._size = 0;
+            return *this;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        size_t size() const noexcept {
+            return _size;
+        }
+
+        // rows every column has room for; a column left larger by a failed
+        // reallocation does not count
+        size_t capacity() const noexcept {
+            return std::apply([](const auto&... col) {
+                size_t ret = size_t(-1);
+                ((ret = val_min(ret, col.length())), ...);
+                return ret;
+            }, _columns);
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        // allocation counters summed over all columns
+        alloc_stats stats() const {
+            alloc_stats ret;
+            std::apply([&ret](const auto&... col) { ((ret += col.stats()), ...); }, _columns);
+            return ret;
+        }
+#endif
+
+        // make the capacity at least num without changing the size
+        void reserve(size_t num) {
+            if (num > capacity()) _reallocate(num);
+        }
+
+        // value-initialize new rows or destroy the ones past sz
+        void resize(size_t sz) {
+            _grow(sz);
+            for (; _size < sz; ++_size)
+                _construct(_indices(), _size, Fields()...);
+            while (_size > sz)
+                _remove(--_size);
+        }
+
+        // drop the unused capacity
+        void shrink_to_fit() {
+            size_t cap = val_max(_size, 1);
+            if (cap < capacity()) _reallocate(cap);
+        }
+
+        reference operator[](size_t idx) {
+            _check(idx);
+            return reference(this, idx);
+        }
+
+        const_reference operator[](size_t idx) const {
+            _check(idx);
+            return const_reference(this, idx);
+        }
+
+        reference at(size_t idx) {
+            return (*this)[idx];
+        }
+
+        const_reference at(size_t idx) const {
+            return (*this)[idx];
+        }
+
+        reference front() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return reference(this, 0);
+        }
+
+        const_reference front() const {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return const_reference(this, 0);
+        }
+
+        reference back() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return reference(this, _size - 1);
+        }
+
+        const_reference back() const {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return const_reference(this, _size - 1);
+        }
+
+        // the values of field I of every row
+        template <size_t I>
+        column_span<field_type<I>> column() noexcept {
+            return column_span<field_type<I>>(_column<I>().data(0), _size);
+        }
+
+        template <size_t I>
+        column_span<const field_type<I>> column() const noexcept {
+            return column_span<const field_type<I>>(_column<I>().data(0), _size);
+        }
+
+        // column<I>().data() carrying the alignment of the allocator's blocks
+        template <size_t I>
+        field_type<I>* aligned_data() noexcept {
+            return assume_aligned<__block_alignment<Allocator<field_type<I>>>::value>(_column<I>().data(0));
+        }
+
+        template <size_t I>
+        const field_type<I>* aligned_data() const noexcept {
+            return assume_aligned<__block_alignment<Allocator<field_type<I>>>::value>(_column<I>().data(0));
+        }
+
+        // append a row built from one argument per field
+        template <class... Args, class = std::enable_if_t<
+            sizeof...(Args) == FIELDS && !_is_row<Args...>::value>>
+        void push_back(Args&&... args) {
+            _grow(_size + 1);
+            _construct(_indices(), _size, Forward<Args>(args)...);
+            ++_size;
+        }
+
+        void push_back(const value_type& x) {
+            _grow(_size + 1);
+            _construct_value(_indices(), _size, x);
+            ++_size;
+        }
+
+        void push_back(value_type&& x) {
+            _grow(_size + 1);
+            _construct_value(_indices(), _size, Move(x));
+            ++_size;
+        }
+
+        void pop_back() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            _remove(--_size);
+        }
+
+        iterator begin() noexcept {
+            return iterator(this, 0);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        iterator end() noexcept {
+            return iterator(this, _size);
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(this, _size);
+        }
+
+        const_iterator cend() const noexcept {
+            return const_iterator(this, _size);
+        }
+
+        iterator erase(size_t idx) {
+            return erase(idx, idx + 1);
+        }
+
+        iterator erase(const_iterator position) {
+            return erase(position._idx, position._idx + 1);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            return erase(first._idx, last._idx);
+        }
+
+        // remove the rows [first, last), shifting every column once
+        iterator erase(size_t first, size_t last) {
+            if (first > last || last > _size) {
+                throw sjtu::index_out_of_bound();
+            }
+            size_t size = _size;
+            _for_columns([first, last, size](auto& col) {
+                col.remove_range(first, last);
+                col.move_range(first, last, size - last);
+            });
+            _size -= last - first;
+            _shrink();
+            return iterator(this, first);
+        }
+
+        // remove every row for which pred(const_reference) holds in one pass,
+        // keeping the order of the others, and return how many were removed
+        template <class Pred>
+        size_t erase_if(Pred pred) {
+            size_t kept = 0;
+            for (size_t i = 0; i < _size; ++i) {
+                if (pred(const_reference(this, i))) continue;
+                if (kept != i) _for_columns([kept, i](auto& col) { *col[kept] = Move(*col[i]); });
+                ++kept;
+            }
+            size_t removed = _size - kept;
+            while (_size > kept)
+                _remove(--_size);
+            _shrink();
+            return removed;
+        }
+
+        // destroy every row, keeping the capacity
+        void clear() {
+            while (_size)
+                _remove(--_size);
+        }
+
+        void swap(basic_soa_vector& x) {
+            _for_columns_with(x, [](auto& col, auto& other) { col.swap(other); }, _indices());
+            s7a9::swap(_size, x._size);
+        }
+
+    private:
+        template <class Other, class Func, size_t... I>
+        inline void _for_columns_with(Other& x, Func&& func, std::index_sequence<I...>) {
+            (func(std::get<I>(_columns), std::get<I>(x._columns)), ...);
+        }
+    };
+
+    // soa_vector<int, float, char> keeps its ints, floats and chars in three
+    // separate __malloc_allocator blocks
+    template <class... Fields>
+    using soa_vector = basic_soa_vector<__malloc_allocator, Fields...>;
+}
+
+#endif // STLITE_SOA_VECTOR_HPP
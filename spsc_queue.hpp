@@ -0,0 +1,201 @@
+#ifndef STLITE_SPSC_QUEUE_HPP
+#define STLITE_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include "allocator.hpp"
+#include "exceptions.hpp"
+
+namespace s7a9 {
+    // Bounded lock-free single-producer/single-consumer ring queue
+    // One thread may call the producer functions (try_push*, try_emplace) and
+    // one other thread the consumer functions (try_pop*, front, pop,
+    // readable, consume). The capacity is rounded up to a power of two so a
+    // position maps to its slot with a mask. Head and tail counters sit on
+    // cache lines of their own, and each side keeps a cached copy of the
+    // other side's counter, so it touches the shared line only when its copy
+    // says the ring is full or empty. readable() exposes the queued elements
+    // in place as at most two spans, for consumers that process a batch
+    // without copying it out.
+    template <class elemType>
+    class spsc_queue {
+    private:
+        static constexpr size_t ALIGN = alignof(elemType) > __aligned_memory<>::CACHE_LINE ?
+            alignof(elemType) : __aligned_memory<>::CACHE_LINE;
+
+        // Largest power-of-two capacity whose slots fit in size_t bytes
+        static constexpr size_t MAX_CAPACITY = size_t(1) << log2_floor(size_t(-1) / sizeof(elemType));
+
+        elemType* _data;
+
+        size_t _mask;
+
+        cache_padded<std::atomic<size_t>> _head; // Next position to read, written by the consumer
+
+        cache_padded<std::atomic<size_t>> _tail; // Next position to write, written by the producer
+
+        cache_padded<size_t> _head_cache; // The producer's last view of _head
+
+        cache_padded<size_t> _tail_cache; // The consumer's last view of _tail
+
+        static inline size_t _round_up(size_t num) {
+            if (num > MAX_CAPACITY) throw sjtu::runtime_error();
+            size_t ret = 2;
+            while (ret < num) ret <<= 1;
+            return ret;
+        }
+
+        // slots free for the producer at tail, refreshing the cached head if needed
+        inline size_t _free_slots(size_t tail, size_t want) noexcept {
+            size_t free = _mask + 1 - (tail - *_head_cache);
+            if (free < want) {
+                *_head_cache = _head->load(std::memory_order_acquire);
+                free = _mask + 1 - (tail - *_head_cache);
+            }
+            return free;
+        }
+
+        // elements ready for the consumer at head, refreshing the cached tail if needed
+        inline size_t _ready(size_t head, size_t want) noexcept {
+            size_t ready = *_tail_cache - head;
+            if (ready < want) {
+                *_tail_cache = _tail->load(std::memory_order_acquire);
+                ready = *_tail_cache - head;
+            }
+            return ready;
+        }
+
+    public:
+        explicit spsc_queue(size_t capacity) {
+            size_t num = _round_up(capacity);
+            _data = static_cast<elemType*>(::operator new(num * sizeof(elemType), std::align_val_t(ALIGN)));
+            _mask = num - 1;
+            _head->store(0, std::memory_order_relaxed);
+            _tail->store(0, std::memory_order_relaxed);
+            *_head_cache = *_tail_cache = 0;
+        }
+
+        spsc_queue(const spsc_queue&) = delete;
+
+        spsc_queue& operator=(const spsc_queue&) = delete;
+
+        ~spsc_queue() {
+            size_t head = _head->load(std::memory_order_relaxed), tail = _tail->load(std::memory_order_relaxed);
+            for (; head != tail; ++head)
+                _data[head & _mask].~elemType();
+            ::operator delete(_data, std::align_val_t(ALIGN));
+        }
+
+        size_t capacity() const noexcept {
+            return _mask + 1;
+        }
+
+        // number of queued elements; only a snapshot while the other side runs
+        size_t size() const noexcept {
+            size_t head = _head->load(std::memory_order_acquire);
+            return _tail->load(std::memory_order_acquire) - head;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        // producer: construct an element from args at the tail, or return false if full
+        template <class... Args>
+        bool try_emplace(Args&&... args) {
+            size_t tail = _tail->load(std::memory_order_relaxed);
+            if (_free_slots(tail, 1) == 0) return false;
+            new(_data + (tail & _mask)) elemType(Forward<Args>(args)...);
+            _tail->store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const elemType& x) {
+            return try_emplace(x);
+        }
+
+        bool try_push(elemType&& x) {
+            return try_emplace(Move(x));
+        }
+
+        // producer: copy up to n elements from first, publishing them at once,
+        // and return how many fitted
+        template <class InputIt>
+        size_t try_push_n(InputIt first, size_t n) {
+            size_t tail = _tail->load(std::memory_order_relaxed);
+            n = val_min(n, _free_slots(tail, n));
+            size_t i = 0;
+            try {
+                for (; i < n; ++i, ++first)
+                    new(_data + ((tail + i) & _mask)) elemType(*first);
+            }
+            catch (...) {
+                while (i--) _data[(tail + i) & _mask].~elemType();
+                throw;
+            }
+            if (n) _tail->store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        // consumer: move the head element into out, or return false if empty
+        bool try_pop(elemType& out) {
+            size_t head = _head->load(std::memory_order_relaxed);
+            if (_ready(head, 1) == 0) return false;
+            elemType& x = _data[head & _mask];
+            out = Move(x);
+            x.~elemType();
+            _head->store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer: move up to n elements to out, freeing their slots at once,
+        // and return how many there were
+        template <class OutputIt>
+        size_t try_pop_n(OutputIt out, size_t n) {
+            size_t head = _head->load(std::memory_order_relaxed);
+            n = val_min(n, _ready(head, n));
+            for (size_t i = 0; i < n; ++i, ++out) {
+                elemType& x = _data[(head + i) & _mask];
+                *out = Move(x);
+                x.~elemType();
+            }
+            if (n) _head->store(head + n, std::memory_order_release);
+            return n;
+        }
+
+        // consumer: the head element in place, or nullptr if empty
+        elemType* front() noexcept {
+            size_t head = _head->load(std::memory_order_relaxed);
+            return _ready(head, 1) ? _data + (head & _mask) : nullptr;
+        }
+
+        // consumer: destroy the head element, which front() returned
+        void pop() {
+            size_t head = _head->load(std::memory_order_relaxed);
+            if (_ready(head, 1) == 0) throw sjtu::container_is_empty();
+            _data[head & _mask].~elemType();
+            _head->store(head + 1, std::memory_order_release);
+        }
+
+        // consumer: every queued element in place, oldest first; the second
+        // span is non-empty when the elements wrap around the end of the ring
+        pair<span<elemType>, span<elemType>> readable() noexcept {
+            size_t head = _head->load(std::memory_order_relaxed), ready = _ready(head, _mask + 1),
+                pos = head & _mask, first = val_min(ready, _mask + 1 - pos);
+            return pair<span<elemType>, span<elemType>>(
+                span<elemType>(_data + pos, first), span<elemType>(_data, ready - first));
+        }
+
+        // consumer: destroy the n oldest elements, e.g. after processing readable()
+        void consume(size_t n) {
+            size_t head = _head->load(std::memory_order_relaxed);
+            if (_ready(head, n) < n) throw sjtu::index_out_of_bound();
+            for (size_t i = 0; i < n; ++i)
+                _data[(head + i) & _mask].~elemType();
+            if (n) _head->store(head + n, std::memory_order_release);
+        }
+    };
+}
+
+#endif // STLITE_SPSC_QUEUE_HPP
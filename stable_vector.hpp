@@ -0,0 +1,560 @@
+#ifndef STLITE_STABLE_VECTOR_HPP
+#define STLITE_STABLE_VECTOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include "allocator.hpp"
+#include "exceptions.hpp"
+
+namespace s7a9 {
+    // Segmented vector whose elements never move when it grows
+    // Segment k holds FIRST_SEGMENT << k slots, so k segments give a capacity
+    // of FIRST_SEGMENT * (2^k - 1), and element i lives in segment
+    // log2(i + FIRST_SEGMENT) - log2(FIRST_SEGMENT): indexing is a clz and a
+    // subtraction. Growth only adds a segment, so pointers, references and
+    // iterators stay valid across push_back() and reserve(), and no growth
+    // ever copies or holds two copies of the elements. Only erase() shifts
+    // elements, like vector.
+    template <class elemType, class Allocator = __malloc_allocator<elemType>, size_t FirstSegment = 16>
+    class stable_vector {
+    public:
+        static constexpr size_t FIRST_SEGMENT = FirstSegment;
+
+    private:
+        static_assert(FirstSegment > 0 && (FirstSegment & (FirstSegment - 1)) == 0,
+            "stable_vector: the first segment size must be a power of two");
+
+        static constexpr size_t FIRST_BITS = log2_floor(FirstSegment),
+            MAX_SEGMENTS = 63 - FIRST_BITS;
+
+        Allocator* _segs[MAX_SEGMENTS]; // The first _seg_num are in use, the rest null
+
+        size_t _seg_num, _size;
+
+        static inline size_t _seg_size(size_t seg) noexcept {
+            return FirstSegment << seg;
+        }
+
+        // total slots of the first seg segments
+        static inline size_t _seg_start(size_t seg) noexcept {
+            return (FirstSegment << seg) - FirstSegment;
+        }
+
+        static inline size_t _seg_of(size_t idx) noexcept {
+            return 63 - clz64(idx + FirstSegment) - FIRST_BITS;
+        }
+
+        inline elemType* _at(size_t idx) noexcept {
+            size_t seg = _seg_of(idx);
+            return _segs[seg]->data(idx - _seg_start(seg));
+        }
+
+        inline const elemType* _at(size_t idx) const noexcept {
+            size_t seg = _seg_of(idx);
+            return _segs[seg]->data(idx - _seg_start(seg));
+        }
+
+        // add segments until there is room for num elements; a moved-from
+        // vector starts over with a default first segment
+        void _grow(size_t num) {
+            if (_seg_num == 0) {
+                _segs[0] = new Allocator(FirstSegment);
+                _seg_num = 1;
+            }
+            while (_seg_start(_seg_num) < num) {
+                if (_seg_num == MAX_SEGMENTS) throw sjtu::runtime_error();
+                _segs[_seg_num] = new Allocator(_seg_size(_seg_num), *_segs[0]);
+                ++_seg_num;
+            }
+        }
+
+        inline void _remove(size_t idx) {
+            size_t seg = _seg_of(idx);
+            _segs[seg]->remove(idx - _seg_start(seg));
+        }
+
+        void _clean() {
+            clear();
+            for (size_t i = 0; i < _seg_num; ++i) {
+                delete _segs[i];
+                _segs[i] = nullptr;
+            }
+            _seg_num = 0;
+        }
+
+        inline void _check(size_t idx) const {
+            if (idx >= _size) throw sjtu::index_out_of_bound();
+        }
+
+    public:
+        class iterator;
+
+        class const_iterator;
+
+        // Random access iterator: the vector and an index, so it stays valid
+        // across growth and points at the same position after an erase()
+        class iterator {
+        private:
+            stable_vector* _v;
+
+            size_t _idx;
+
+            friend class stable_vector;
+
+            friend class stable_vector::const_iterator;
+
+            iterator(stable_vector* v, size_t idx) noexcept :
+                _v(v), _idx(idx) {}
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef elemType value_type;
+            typedef ptrdiff_t difference_type;
+            typedef elemType* pointer;
+            typedef elemType& reference;
+
+            iterator() noexcept : _v(nullptr), _idx(0) {}
+
+            inline elemType& operator*() const noexcept {
+                return *_v->_at(_idx);
+            }
+
+            inline elemType* operator->() const noexcept {
+                return _v->_at(_idx);
+            }
+
+            inline elemType& operator[](ptrdiff_t offset) const noexcept {
+                return *_v->_at(_idx + offset);
+            }
+
+            inline iterator& operator++() noexcept {
+                ++_idx;
+                return *this;
+            }
+
+            inline iterator operator++(int) noexcept {
+                iterator iter(*this);
+                ++_idx;
+                return iter;
+            }
+
+            inline iterator& operator--() noexcept {
+                --_idx;
+                return *this;
+            }
+
+            inline iterator operator--(int) noexcept {
+                iterator iter(*this);
+                --_idx;
+                return iter;
+            }
+
+            inline iterator& operator+=(ptrdiff_t offset) noexcept {
+                _idx += offset;
+                return *this;
+            }
+
+            inline iterator& operator-=(ptrdiff_t offset) noexcept {
+                _idx -= offset;
+                return *this;
+            }
+
+            inline iterator operator+(ptrdiff_t offset) const noexcept {
+                return iterator(_v, _idx + offset);
+            }
+
+            inline iterator operator-(ptrdiff_t offset) const noexcept {
+                return iterator(_v, _idx - offset);
+            }
+
+            friend inline iterator operator+(ptrdiff_t offset, const iterator& iter) noexcept {
+                return iter + offset;
+            }
+
+            friend inline ptrdiff_t operator-(const iterator& lhs, const iterator& rhs) noexcept {
+                return ptrdiff_t(lhs._idx) - ptrdiff_t(rhs._idx);
+            }
+
+            inline bool operator==(const iterator& rhs) const noexcept {
+                return _v == rhs._v && _idx == rhs._idx;
+            }
+
+            inline bool operator!=(const iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            inline bool operator<(const iterator& rhs) const noexcept {
+                return _idx < rhs._idx;
+            }
+
+            inline bool operator>(const iterator& rhs) const noexcept {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const iterator& rhs) const noexcept {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const iterator& rhs) const noexcept {
+                return !(*this < rhs);
+            }
+        };
+
+        class const_iterator {
+        private:
+            const stable_vector* _v;
+
+            size_t _idx;
+
+            friend class stable_vector;
+
+            const_iterator(const stable_vector* v, size_t idx) noexcept :
+                _v(v), _idx(idx) {}
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef elemType value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const elemType* pointer;
+            typedef const elemType& reference;
+
+            const_iterator() noexcept : _v(nullptr), _idx(0) {}
+
+            const_iterator(const iterator& iter) noexcept :
+                _v(iter._v), _idx(iter._idx) {}
+
+            inline const elemType& operator*() const noexcept {
+                return *_v->_at(_idx);
+            }
+
+            inline const elemType* operator->() const noexcept {
+                return _v->_at(_idx);
+            }
+
+            inline const elemType& operator[](ptrdiff_t offset) const noexcept {
+                return *_v->_at(_idx + offset);
+            }
+
+            inline const_iterator& operator++() noexcept {
+                ++_idx;
+                return *this;
+            }
+
+            inline const_iterator operator++(int) noexcept {
+                const_iterator iter(*this);
+                ++_idx;
+                return iter;
+            }
+
+            inline const_iterator& operator--() noexcept {
+                --_idx;
+                return *this;
+            }
+
+            inline const_iterator operator--(int) noexcept {
+                const_iterator iter(*this);
+                --_idx;
+                return iter;
+            }
+
+            inline const_iterator& operator+=(ptrdiff_t offset) noexcept {
+                _idx += offset;
+                return *this;
+            }
+
+            inline const_iterator& operator-=(ptrdiff_t offset) noexcept {
+                _idx -= offset;
+                return *this;
+            }
+
+            inline const_iterator operator+(ptrdiff_t offset) const noexcept {
+                return const_iterator(_v, _idx + offset);
+            }
+
+            inline const_iterator operator-(ptrdiff_t offset) const noexcept {
+                return const_iterator(_v, _idx - offset);
+            }
+
+            friend inline const_iterator operator+(ptrdiff_t offset, const const_iterator& iter) noexcept {
+                return iter + offset;
+            }
+
+            friend inline ptrdiff_t operator-(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+                return ptrdiff_t(lhs._idx) - ptrdiff_t(rhs._idx);
+            }
+
+            inline bool operator==(const const_iterator& rhs) const noexcept {
+                return _v == rhs._v && _idx == rhs._idx;
+            }
+
+            inline bool operator!=(const const_iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            inline bool operator<(const const_iterator& rhs) const noexcept {
+                return _idx < rhs._idx;
+            }
+
+            inline bool operator>(const const_iterator& rhs) const noexcept {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const const_iterator& rhs) const noexcept {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const const_iterator& rhs) const noexcept {
+                return !(*this < rhs);
+            }
+        };
+
+        stable_vector() :
+            _segs(), _seg_num(1), _size(0) {
+            _segs[0] = new Allocator(FirstSegment);
+        }
+
+        // empty vector whose segments are built from alloc_arg, e.g. the
+        // std::pmr::memory_resource* of a __pmr_allocator
+        template <class Arg, class = std::enable_if_t<
+            std::is_constructible<Allocator, size_t, Arg&&>::value>>
+        explicit stable_vector(Arg&& alloc_arg) :
+            _segs(), _seg_num(1), _size(0) {
+            _segs[0] = new Allocator(FirstSegment, Forward<Arg>(alloc_arg));
+        }
+
+        stable_vector(size_t num, const elemType& value) :
+            stable_vector() {
+            reserve(num);
+            for (size_t i = 0; i < num; ++i)
+                push_back(value);
+        }
+
+        stable_vector(const stable_vector& x) :
+            _segs(), _seg_num(1), _size(0) {
+            _segs[0] = x._seg_num ? new Allocator(FirstSegment, *x._segs[0]) : new Allocator(FirstSegment);
+            reserve(x._size);
+            for (size_t i = 0; i < x._size; ++i)
+                push_back(*x._at(i));
+        }
+
+        stable_vector(stable_vector&& x) noexcept :
+            _segs(), _seg_num(x._seg_num), _size(x._size) {
+            for (size_t i = 0; i < _seg_num; ++i)
+                _segs[i] = x._segs[i], x._segs[i] = nullptr;
+            x._seg_num = x._size = 0;
+        }
+
+        ~stable_vector() {
+            _clean();
+        }
+
+        stable_vector& operator=(const stable_vector& rhs) {
+            if (this == &rhs) return *this;
+            clear();
+            reserve(rhs._size);
+            for (size_t i = 0; i < rhs._size; ++i)
+                push_back(*rhs._at(i));
+            return *this;
+        }
+
+        stable_vector& operator=(stable_vector&& rhs) noexcept {
+            if (this == &rhs) return *this;
+            _clean();
+            _seg_num = rhs._seg_num, _size = rhs._size;
+            for (size_t i = 0; i < _seg_num; ++i)
+                _segs[i] = rhs._segs[i], rhs._segs[i] = nullptr;
+            rhs._seg_num = rhs._size = 0;
+            return *this;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        size_t size() const noexcept {
+            return _size;
+        }
+
+        size_t capacity() const noexcept {
+            return _seg_start(_seg_num);
+        }
+
+        size_t segment_count() const noexcept {
+            return _seg_num;
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        // allocation counters summed over all segments
+        alloc_stats stats() const {
+            alloc_stats ret;
+            for (size_t i = 0; i < _seg_num; ++i)
+                ret += _segs[i]->stats();
+            return ret;
+        }
+#endif
+
+        // make the capacity at least num; existing elements stay where they are
+        void reserve(size_t num) {
+            _grow(num);
+        }
+
+        // value-initialize new elements or destroy the ones past sz
+        void resize(size_t sz) {
+            _grow(sz);
+            for (; _size < sz; ++_size)
+                _emplace_at(_size);
+            while (_size > sz)
+                _remove(--_size);
+        }
+
+        void resize(size_t sz, const elemType& value) {
+            _grow(sz);
+            for (; _size < sz; ++_size)
+                _emplace_at(_size, value);
+            while (_size > sz)
+                _remove(--_size);
+        }
+
+        // free the segments that hold no element; the first one is kept
+        void shrink_to_fit() {
+            while (_seg_num > 1 && _seg_start(_seg_num - 1) >= _size) {
+                delete _segs[--_seg_num];
+                _segs[_seg_num] = nullptr;
+            }
+        }
+
+        elemType& operator[](size_t idx) {
+            _check(idx);
+            return *_at(idx);
+        }
+
+        const elemType& operator[](size_t idx) const {
+            _check(idx);
+            return *_at(idx);
+        }
+
+        elemType& at(size_t idx) {
+            _check(idx);
+            return *_at(idx);
+        }
+
+        const elemType& at(size_t idx) const {
+            _check(idx);
+            return *_at(idx);
+        }
+
+        elemType& front() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return *_at(0);
+        }
+
+        const elemType& front() const {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return *_at(0);
+        }
+
+        elemType& back() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return *_at(_size - 1);
+        }
+
+        const elemType& back() const {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return *_at(_size - 1);
+        }
+
+        void push_back(const elemType& x) {
+            _emplace_at(_size, x);
+            ++_size;
+        }
+
+        void push_back(elemType&& x) {
+            _emplace_at(_size, Move(x));
+            ++_size;
+        }
+
+        template <class... Args>
+        elemType& emplace_back(Args&&... args) {
+            elemType* p = _emplace_at(_size, Forward<Args>(args)...);
+            ++_size;
+            return *p;
+        }
+
+        void pop_back() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            _remove(--_size);
+        }
+
+        iterator begin() noexcept {
+            return iterator(this, 0);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        iterator end() noexcept {
+            return iterator(this, _size);
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(this, _size);
+        }
+
+        const_iterator cend() const noexcept {
+            return const_iterator(this, _size);
+        }
+
+        iterator erase(size_t idx) {
+            return erase(begin() + idx, begin() + idx + 1);
+        }
+
+        iterator erase(const_iterator position) {
+            return erase(position, position + 1);
+        }
+
+        // move the tail over [first, last) and destroy the last elements
+        iterator erase(const_iterator first, const_iterator last) {
+            size_t pos1 = first._idx, pos2 = last._idx;
+            if (first._v != this || last._v != this) throw sjtu::invalid_iterator();
+            if (pos1 > pos2 || pos2 > _size) throw sjtu::index_out_of_bound();
+            for (size_t i = pos2; i < _size; ++i)
+                *_at(pos1 + i - pos2) = Move(*_at(i));
+            size_t new_size = _size - (pos2 - pos1);
+            while (_size > new_size)
+                _remove(--_size);
+            return iterator(this, pos1);
+        }
+
+        // destroy every element, keeping the segments
+        void clear() {
+            while (_size)
+                _remove(--_size);
+        }
+
+        void swap(stable_vector& x) noexcept {
+            // entries past _seg_num are null, so both sides can be swapped whole
+            size_t seg_num = val_max(_seg_num, x._seg_num);
+            for (size_t i = 0; i < seg_num; ++i)
+                s7a9::swap(_segs[i], x._segs[i]);
+            s7a9::swap(_seg_num, x._seg_num);
+            s7a9::swap(_size, x._size);
+        }
+
+    private:
+        // construct element idx in place, adding a segment if needed
+        template <class... Args>
+        elemType* _emplace_at(size_t idx, Args&&... args) {
+            _grow(idx + 1);
+            size_t seg = _seg_of(idx);
+            _segs[seg]->emplace(idx - _seg_start(seg), Forward<Args>(args)...);
+            return _segs[seg]->data(idx - _seg_start(seg));
+        }
+    };
+}
+
+#endif // STLITE_STABLE_VECTOR_HPP
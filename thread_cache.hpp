@@ -0,0 +1,273 @@
+#ifndef STLITE_THREAD_CACHE_HPP
+#define STLITE_THREAD_CACHE_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include "utilities.hpp"
+#include "allocator_stats.hpp"
+
+namespace s7a9 {
+    // Per-thread cache of free nodes of one size class
+    // Nodes are carved out of SLAB_BYTES-aligned slabs whose header records the
+    // cache that carved them. A node freed by its owner thread goes back to the
+    // owner's local list; a node freed by another thread is pushed onto the
+    // owner's remote-free stack (lock-free, at most REMOTE_LIMIT nodes), and
+    // kept by the freeing thread once that stack is full. Local lists longer
+    // than LOCAL_LIMIT spill BATCH nodes into a mutex-protected depot shared by
+    // all threads. A node freed during thread exit, after the thread's own
+    // cache was handed back, always goes onto its owner's remote-free stack.
+    // Slabs are never returned to the system.
+    template <size_t SlotSize>
+    class __thread_node_cache {
+    private:
+        static constexpr size_t SLAB_BYTES = 64 * 1024,
+            LOCAL_LIMIT = 1024, BATCH = LOCAL_LIMIT / 2, REMOTE_LIMIT = 4096;
+
+        struct slot_t {
+            slot_t* next;
+            slot_t* next_batch; // Only used by the batches kept in the depot
+        };
+
+        struct slab_t {
+            __thread_node_cache* owner;
+            slab_t* next;
+        };
+
+        static constexpr size_t SLAB_HEADER = (sizeof(slab_t) + 15) / 16 * 16;
+
+        static_assert(SlotSize >= sizeof(slot_t) && SlotSize % 16 == 0,
+            "__thread_node_cache: bad size class");
+        static_assert((SLAB_BYTES - SLAB_HEADER) / SlotSize >= 8,
+            "__thread_node_cache: node too large for a slab");
+
+        // State shared by all threads, never destroyed
+        struct depot_t {
+            std::mutex lock;
+            slot_t* batches = nullptr; // Full batches of BATCH nodes
+            __thread_node_cache* idle = nullptr; // Caches left by exited threads
+            slab_t* slabs = nullptr; // Every slab, kept reachable
+        };
+
+        // Binds a cache to the current thread and hands it back on thread exit
+        struct handle_t {
+            __thread_node_cache* cache;
+
+            handle_t() : cache(_acquire()) {}
+
+            ~handle_t() {
+                _exited = true;
+                _retire(cache);
+            }
+        };
+
+        // Set once the calling thread's handle is destroyed; a plain flag, so
+        // it stays readable from destructors that run later in thread exit
+        static inline thread_local bool _exited = false;
+
+        slot_t* _local;
+
+        size_t _local_num;
+
+        char* _cur, * _lim; // Untouched part of the newest slab
+
+        __thread_node_cache* _next_idle;
+
+        std::atomic<slot_t*> _remote;
+
+        std::atomic<size_t> _remote_num;
+
+        __thread_node_cache() noexcept :
+            _local(nullptr), _local_num(0), _cur(nullptr), _lim(nullptr),
+            _next_idle(nullptr), _remote(nullptr), _remote_num(0) {}
+
+        static depot_t& _depot() {
+            static depot_t* depot = new depot_t();
+            return *depot;
+        }
+
+        static __thread_node_cache* _acquire() {
+            depot_t& depot = _depot();
+            std::lock_guard<std::mutex> guard(depot.lock);
+            if (depot.idle == nullptr) return new __thread_node_cache();
+            __thread_node_cache* cache = depot.idle;
+            depot.idle = cache->_next_idle;
+            cache->_next_idle = nullptr;
+            return cache;
+        }
+
+        static void _retire(__thread_node_cache* cache) {
+            depot_t& depot = _depot();
+            while (cache->_local_num >= BATCH) cache->_flush();
+            std::lock_guard<std::mutex> guard(depot.lock);
+            cache->_next_idle = depot.idle;
+            depot.idle = cache;
+        }
+
+        static inline slab_t* _slab_of(void* p) noexcept {
+            return reinterpret_cast<slab_t*>(reinterpret_cast<size_t>(p) & ~(SLAB_BYTES - 1));
+        }
+
+        // move BATCH nodes of the local list into the depot
+        void _flush() {
+            slot_t* head = _local, * tail = _local;
+            for (size_t i = 1; i < BATCH; ++i) tail = tail->next;
+            _local = tail->next, _local_num -= BATCH;
+            tail->next = nullptr;
+            depot_t& depot = _depot();
+            std::lock_guard<std::mutex> guard(depot.lock);
+            head->next_batch = depot.batches;
+            depot.batches = head;
+        }
+
+        void _new_slab() {
+#ifdef _MSC_VER
+            void* mem = _aligned_malloc(SLAB_BYTES, SLAB_BYTES);
+#else
+            void* mem = aligned_alloc(SLAB_BYTES, SLAB_BYTES);
+#endif
+            if (mem == nullptr) throw std::bad_alloc();
+            slab_t* slab = static_cast<slab_t*>(mem);
+            slab->owner = this;
+            _cur = static_cast<char*>(mem) + SLAB_HEADER;
+            _lim = _cur + (SLAB_BYTES - SLAB_HEADER) / SlotSize * SlotSize;
+            depot_t& depot = _depot();
+            std::lock_guard<std::mutex> guard(depot.lock);
+            slab->next = depot.slabs;
+            depot.slabs = slab;
+        }
+
+        // local list is empty: take remote frees, then a depot batch, then a new slab
+        void* _allocate_slow() {
+            if (_remote.load(std::memory_order_relaxed)) {
+                slot_t* head = _remote.exchange(nullptr, std::memory_order_acquire);
+                size_t num = 0;
+                for (slot_t* s = head; s; s = s->next) ++num;
+                _remote_num.fetch_sub(num, std::memory_order_relaxed);
+                _local = head, _local_num = num;
+            }
+            if (_local == nullptr) {
+                depot_t& depot = _depot();
+                std::lock_guard<std::mutex> guard(depot.lock);
+                if (depot.batches) {
+                    _local = depot.batches, _local_num = BATCH;
+                    depot.batches = _local->next_batch;
+                }
+            }
+            if (_local) {
+                slot_t* slot = _local;
+                _local = slot->next, --_local_num;
+                return slot;
+            }
+            if (_cur == _lim) _new_slab();
+            void* ret = _cur;
+            _cur += SlotSize;
+            return ret;
+        }
+
+        inline void _push_local(void* p) {
+            slot_t* slot = static_cast<slot_t*>(p);
+            slot->next = _local, _local = slot;
+            if (++_local_num > LOCAL_LIMIT) _flush();
+        }
+
+        inline void _push_remote(void* p) noexcept {
+            _remote_num.fetch_add(1, std::memory_order_relaxed);
+            slot_t* slot = static_cast<slot_t*>(p);
+            slot->next = _remote.load(std::memory_order_relaxed);
+            while (!_remote.compare_exchange_weak(slot->next, slot,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        inline bool _try_push_remote(void* p) noexcept {
+            if (_remote_num.load(std::memory_order_relaxed) >= REMOTE_LIMIT) return false;
+            _push_remote(p);
+            return true;
+        }
+
+    public:
+        // the cache of the calling thread; not to be used once the thread
+        // handed it back at exit
+        static __thread_node_cache& local() {
+            static thread_local handle_t handle;
+            return *handle.cache;
+        }
+
+        inline void* allocate() {
+            if (_local == nullptr) return _allocate_slow();
+            slot_t* slot = _local;
+            _local = slot->next, --_local_num;
+            return slot;
+        }
+
+        // p may come from any thread's cache of this size class
+        static inline void deallocate(void* p) {
+            __thread_node_cache* owner = _slab_of(p)->owner;
+            if (_exited) {
+                owner->_push_remote(p);
+                return;
+            }
+            __thread_node_cache& self = local();
+            if (owner != &self && owner->_try_push_remote(p)) return;
+            self._push_local(p);
+        }
+    };
+
+    // Node allocator: front-end over the calling thread's node cache
+    // Containers of different threads never contend on a lock in the common
+    // case, and a container may be destroyed on another thread than the one
+    // that filled it.
+    template <class nodeType>
+    class __thread_cached_allocator {
+    private:
+        static constexpr size_t SLOT_SIZE = (sizeof(nodeType) + 15) / 16 * 16;
+
+        static_assert(alignof(nodeType) <= 16,
+            "__thread_cached_allocator: node alignment exceeds the size class");
+
+        typedef __thread_node_cache<SLOT_SIZE> cache_t;
+
+        STLITE_STATS(__stats_counter _counter{ "thread_cached_allocator" };)
+
+    public:
+        __thread_cached_allocator() noexcept = default;
+
+        __thread_cached_allocator(const __thread_cached_allocator&) noexcept {}
+
+        __thread_cached_allocator(__thread_cached_allocator&& x) noexcept {
+            STLITE_STATS(_counter.swap(x._counter);)
+        }
+
+        inline nodeType* allocate() {
+            void* p = cache_t::local().allocate();
+            STLITE_STATS(_counter.on_alloc(sizeof(nodeType));)
+            return static_cast<nodeType*>(p);
+        }
+
+        inline void deallocate(nodeType* p) noexcept {
+            STLITE_STATS(_counter.on_free(sizeof(nodeType));)
+            cache_t::deallocate(p);
+        }
+
+        // every node went back to a cache when it was deallocated
+        inline void release() noexcept {}
+
+        // nodes are not tied to a container, only the counts are taken over
+        inline void merge(__thread_cached_allocator& other) noexcept {
+            STLITE_STATS(if (this != &other) _counter.merge(other._counter);)
+        }
+
+        inline void swap(__thread_cached_allocator& other) noexcept {
+            STLITE_STATS(_counter.swap(other._counter);)
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        inline alloc_stats stats() const noexcept {
+            return _counter.stats();
+        }
+#endif
+    };
+}
+
+#endif // STLITE_THREAD_CACHE_HPP
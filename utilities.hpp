@@ -1,25 +1,9 @@
 #ifndef STLITE_UTILITIES_HPP
 #define STLITE_UTILITIES_HPP
 
-namespace sjtu {
-    template<class T1, class T2>
-    class pair {
-    public:
-        T1 first;
-        T2 second;
-        constexpr pair() : first(), second() {}
-        pair(const pair& other) = default;
-        pair(pair&& other) = default;
-        pair(const T1& x, const T2& y) : first(x), second(y) {}
-        template<class U1, class U2>
-        pair(U1&& x, U2&& y) : first(x), second(y) {}
-        template<class U1, class U2>
-        pair(const pair<U1, U2>& other) : first(other.first), second(other.second) {}
-        template<class U1, class U2>
-        pair(pair<U1, U2>&& other) : first(other.first), second(other.second) {}
-    };
-
-}
+#include <iterator>
+#include <type_traits>
+#include "utility.hpp"
 
 namespace s7a9 {
     template <typename T> struct RemoveReference {
@@ -37,11 +21,21 @@ namespace s7a9 {
         return static_cast<typename RemoveReference<T>::type&&>(t);
     }
 
+    template <typename T>
+    T&& Forward(typename RemoveReference<T>::type& t) {
+        return static_cast<T&&>(t);
+    }
+
+    template <typename T>
+    T&& Forward(typename RemoveReference<T>::type&& t) {
+        return static_cast<T&&>(t);
+    }
+
     template <typename T>
     inline void swap(T& a, T& b) {
-        T tmp(a);
-        a = b;
-        b = tmp;
+        T tmp(Move(a));
+        a = Move(b);
+        b = Move(tmp);
     }
 
     template <typename T1, typename T2>
@@ -56,6 +50,102 @@ namespace s7a9 {
         else return b;
     }
 
+    // Count trailing zeros of a non-zero word
+    inline unsigned ctz64(unsigned long long x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+        unsigned n = 0;
+        while (!(x & 1ULL)) x >>= 1, ++n;
+        return n;
+#endif
+    }
+
+    // Count leading zeros of a non-zero word
+    inline unsigned clz64(unsigned long long x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_clzll(x));
+#else
+        unsigned n = 0;
+        while (!(x & (1ULL << 63))) x <<= 1, ++n;
+        return n;
+#endif
+    }
+
+    // floor(log2(x)) of a non-zero value, usable in constant expressions
+    constexpr unsigned log2_floor(unsigned long long x) noexcept {
+        return x == 1 ? 0 : 1 + log2_floor(x >> 1);
+    }
+
+    // Number of set bits in a word
+    inline unsigned popcount64(unsigned long long x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+        unsigned n = 0;
+        for (; x; x &= x - 1) ++n;
+        return n;
+#endif
+    }
+
+    // Tell the compiler that p is aligned to Align bytes
+    template <size_t Align, typename T>
+    inline T* assume_aligned(T* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<T*>(__builtin_assume_aligned(p, Align));
+#else
+        return p;
+#endif
+    }
+
+    // Whether It is an iterator of at least the given category
+    template <class It, class Category = std::input_iterator_tag, class = void>
+    struct __is_iterator : std::false_type {};
+
+    template <class It, class Category>
+    struct __is_iterator<It, Category, std::void_t<typename std::iterator_traits<It>::iterator_category>> :
+        std::is_base_of<Category, typename std::iterator_traits<It>::iterator_category> {};
+
+    // Non-owning view of n contiguous values
+    template <class T>
+    class span {
+    private:
+        T* _p;
+
+        size_t _n;
+
+    public:
+        span() noexcept :
+            _p(nullptr), _n(0) {}
+
+        span(T* p, size_t n) noexcept :
+            _p(p), _n(n) {}
+
+        inline T* data() const noexcept {
+            return _p;
+        }
+
+        inline size_t size() const noexcept {
+            return _n;
+        }
+
+        [[nodiscard]] inline bool empty() const noexcept {
+            return _n == 0;
+        }
+
+        inline T& operator[](size_t idx) const noexcept {
+            return _p[idx];
+        }
+
+        inline T* begin() const noexcept {
+            return _p;
+        }
+
+        inline T* end() const noexcept {
+            return _p + _n;
+        }
+    };
+
     template <class T1, class T2>
     using pair = sjtu::pair<T1, T2>;
 }
@@ -4,182 +4,430 @@
 #ifdef VECTOR_INITIALIZER_LIST_ENABLED
 #include <initializer_list>
 #endif
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
 #include "allocator.hpp"
 #include "exceptions.hpp"
 
+// A full vector grows its capacity by VECTOR_GROWTH_NUM / VECTOR_GROWTH_DEN
+#ifndef VECTOR_GROWTH_NUM
+#define VECTOR_GROWTH_NUM 2
+#endif
+#ifndef VECTOR_GROWTH_DEN
+#define VECTOR_GROWTH_DEN 1
+#endif
+
 namespace s7a9 {
+    // Capacity policy, with g = VECTOR_GROWTH_NUM / VECTOR_GROWTH_DEN:
+    // a full vector grows to g times its capacity (or to what is needed), and
+    // erase() shrinks a capacity c to c / g only once fewer than c / g^2
+    // elements are left. After any reallocation to capacity c, at least
+    // c (1 - 1/g) pushes or c (1/g - 1/g^2) erases must happen before the next
+    // one, so push_back() and erase() at the end are amortized O(1) and a
+    // size oscillating around any boundary never reallocates. clear() and
+    // reserve() keep the capacity; only shrink_to_fit() gives memory back.
     template <class elemType, class Allocator = __malloc_allocator<elemType>>
     class vector {
+    public:
+        class iterator;
+
+        class const_iterator;
+
     private:
+        static constexpr size_t INLINE_CAPACITY = __inline_bytes<Allocator>::value / sizeof(elemType),
+            MIN_CAPACITY = INLINE_CAPACITY ? INLINE_CAPACITY : 10,
+            GROWTH_NUM = VECTOR_GROWTH_NUM, GROWTH_DEN = VECTOR_GROWTH_DEN;
+
+        static_assert(GROWTH_NUM > GROWTH_DEN && GROWTH_DEN > 0, "vector: growth factor must exceed 1");
+
+        static_assert(__is_contiguous<Allocator>::value, "vector: the allocator must store slots contiguously");
+
         Allocator _allocator;
 
         size_t _size;
 
+        // make room for num elements, growing by the growth factor at least;
+        // throws bad_alloc and keeps the elements if memory runs out
+        inline void _grow(size_t num) {
+            size_t cap = _allocator.length();
+            if (num <= cap) return;
+            if (_allocator.reallocate(val_max(val_max(num, cap / GROWTH_DEN * GROWTH_NUM), MIN_CAPACITY)) == nullptr)
+                throw std::bad_alloc();
+        }
+
+        inline elemType* _begin() noexcept {
+            return _allocator.data(0);
+        }
+
+        inline const elemType* _begin() const noexcept {
+            return _allocator.data(0);
+        }
+
+        // index of position, which must belong to this vector
+        inline size_t _index(const_iterator position) const {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            if (position._owner != this) throw sjtu::invalid_iterator();
+#endif
+            return position._p - _begin();
+        }
+
+        template <class It>
+        static inline It _raw(It it) noexcept {
+            return it;
+        }
+
+        static inline elemType* _raw(iterator it) noexcept {
+            return it._p;
+        }
+
+        static inline const elemType* _raw(const_iterator it) noexcept {
+            return it._p;
+        }
+
+        // copy n values from first into [pos, pos + n), shifting the tail once;
+        // on an exception the vector is left as it was
+        template <class ForwardIt>
+        void _insert_range(size_t pos, ForwardIt first, size_t n) {
+            if (n == 0) return;
+            _grow(_size + n);
+            _allocator.move_range(pos + n, pos, _size - pos);
+            try {
+                _allocator.construct_range(pos, first, n);
+            }
+            catch (...) {
+                for (size_t i = pos; i < pos + n; ++i)
+                    _allocator.remove(i);
+                _allocator.move_range(pos, pos + n, _size - pos);
+                throw;
+            }
+            _size += n;
+        }
+
+        // give memory back once the vector is well below its capacity; a shrink
+        // that runs out of memory keeps the old block
+        inline void _shrink() {
+            size_t cap = _allocator.length();
+            if (cap > MIN_CAPACITY && _size * GROWTH_NUM * GROWTH_NUM < cap * GROWTH_DEN * GROWTH_DEN)
+                _allocator.reallocate(val_max(cap / GROWTH_NUM * GROWTH_DEN, MIN_CAPACITY));
+        }
+
     public:
+        // Contiguous iterator: a raw element pointer. With
+        // VECTOR_ITERATOR_CHECK_ENABLED it also remembers its vector, and
+        // dereferencing outside [begin(), end()) or mixing iterators of
+        // different vectors throws invalid_iterator.
         class iterator {
         private:
-            Allocator* _palloc;
+            elemType* _p;
+
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            const vector* _owner;
+
+            inline void _check(const elemType* p) const {
+                if (_owner == nullptr || p < _owner->_begin() || p >= _owner->_begin() + _owner->_size)
+                    throw sjtu::invalid_iterator();
+            }
+
+            inline void _check_same(const iterator& rhs) const {
+                if (_owner != rhs._owner) throw sjtu::invalid_iterator();
+            }
+#endif
 
-            size_t _idx;
+            friend class vector;
 
             friend class vector::const_iterator;
 
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            iterator(elemType* p, const vector* owner) noexcept :
+                _p(p), _owner(owner) {}
+#else
+            iterator(elemType* p, const vector*) noexcept :
+                _p(p) {}
+#endif
+
         public:
-            iterator(Allocator* p_alloc, size_t idx) {
-                _palloc = p_alloc;
-                _idx = idx;
+            typedef std::random_access_iterator_tag iterator_category;
+#if __cplusplus > 201703L
+            typedef std::contiguous_iterator_tag iterator_concept;
+#endif
+            typedef elemType value_type;
+            typedef ptrdiff_t difference_type;
+            typedef elemType* pointer;
+            typedef elemType& reference;
+
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            iterator() noexcept : _p(nullptr), _owner(nullptr) {}
+#else
+            iterator() noexcept : _p(nullptr) {}
+#endif
+
+            inline elemType& operator*() const {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+                _check(_p);
+#endif
+                return *_p;
+            }
+
+            inline elemType* operator->() const {
+                return &**this;
             }
 
-            elemType& operator*() {
-                return *(_palloc->data(_idx));
+            inline elemType& operator[](ptrdiff_t offset) const {
+                return *(*this + offset);
             }
 
-            iterator& operator++() {
-                if (_palloc->has_value(_idx)) ++_idx;
+            inline iterator& operator++() noexcept {
+                ++_p;
                 return *this;
             }
 
-            iterator operator+(long long offset) {
-                return iterator(_palloc, _idx + offset);
+            inline iterator operator++(int) noexcept {
+                iterator iter(*this);
+                ++_p;
+                return iter;
             }
 
-            iterator operator-(long long offset) {
-                return iterator(_palloc, _idx - offset);
+            inline iterator& operator--() noexcept {
+                --_p;
+                return *this;
             }
 
-            iterator operator++(int) {
+            inline iterator operator--(int) noexcept {
                 iterator iter(*this);
-                ++(*this);
+                --_p;
                 return iter;
             }
 
-            friend long long operator-(const iterator& lhs, const iterator& rhs) {
-                if (lhs._palloc != rhs._palloc) throw sjtu::invalid_iterator();
-                return (long long)lhs._idx - rhs._idx;
+            inline iterator& operator+=(ptrdiff_t offset) noexcept {
+                _p += offset;
+                return *this;
             }
 
-            iterator& operator--() {
-                if (_idx) --_idx;
-                else throw sjtu::invalid_iterator();
+            inline iterator& operator-=(ptrdiff_t offset) noexcept {
+                _p -= offset;
                 return *this;
             }
 
-            iterator& operator+=(long long offset) {
-                _idx += offset;
-                return *this;
+            inline iterator operator+(ptrdiff_t offset) const noexcept {
+                iterator iter(*this);
+                return iter += offset;
             }
 
-            iterator& operator-=(long long offset) {
-                _idx -= offset;
-                return *this;
+            friend inline iterator operator+(ptrdiff_t offset, const iterator& iter) noexcept {
+                return iter + offset;
             }
 
-            iterator operator--(int) {
+            inline iterator operator-(ptrdiff_t offset) const noexcept {
                 iterator iter(*this);
-                --(*this);
-                return iter;
+                return iter -= offset;
+            }
+
+            friend inline ptrdiff_t operator-(const iterator& lhs, const iterator& rhs) {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+                lhs._check_same(rhs);
+#endif
+                return lhs._p - rhs._p;
             }
 
-            bool operator==(const iterator& rhs) const {
-                if (_palloc != rhs._palloc) throw sjtu::invalid_iterator();
-                return _palloc == rhs._palloc && _idx == rhs._idx;
+            inline bool operator==(const iterator& rhs) const {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+                _check_same(rhs);
+#endif
+                return _p == rhs._p;
             }
 
-            bool operator!=(const iterator& rhs) const {
-                if (_palloc != rhs._palloc) throw sjtu::invalid_iterator();
+            inline bool operator!=(const iterator& rhs) const {
                 return !(*this == rhs);
             }
+
+            inline bool operator<(const iterator& rhs) const {
+                return *this - rhs < 0;
+            }
+
+            inline bool operator>(const iterator& rhs) const {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const iterator& rhs) const {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const iterator& rhs) const {
+                return !(*this < rhs);
+            }
         };
 
         class const_iterator {
         private:
-            const Allocator* _palloc;
+            const elemType* _p;
+
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            const vector* _owner;
 
-            size_t _idx;
+            inline void _check(const elemType* p) const {
+                if (_owner == nullptr || p < _owner->_begin() || p >= _owner->_begin() + _owner->_size)
+                    throw sjtu::invalid_iterator();
+            }
+
+            inline void _check_same(const const_iterator& rhs) const {
+                if (_owner != rhs._owner) throw sjtu::invalid_iterator();
+            }
+#endif
 
             friend class vector;
 
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            const_iterator(const elemType* p, const vector* owner) noexcept :
+                _p(p), _owner(owner) {}
+#else
+            const_iterator(const elemType* p, const vector*) noexcept :
+                _p(p) {}
+#endif
+
         public:
-            const_iterator(const iterator& iter) :
-                _palloc(iter._palloc), _idx(iter._idx) {}
+            typedef std::random_access_iterator_tag iterator_category;
+#if __cplusplus > 201703L
+            typedef std::contiguous_iterator_tag iterator_concept;
+#endif
+            typedef elemType value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const elemType* pointer;
+            typedef const elemType& reference;
+
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+            const_iterator() noexcept : _p(nullptr), _owner(nullptr) {}
 
-            const_iterator(const Allocator* p_alloc, size_t idx) :
-                _palloc(p_alloc), _idx(idx) {}
+            const_iterator(const iterator& iter) noexcept :
+                _p(iter._p), _owner(iter._owner) {}
+#else
+            const_iterator() noexcept : _p(nullptr) {}
+
+            const_iterator(const iterator& iter) noexcept :
+                _p(iter._p) {}
+#endif
+
+            inline const elemType& operator*() const {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+                _check(_p);
+#endif
+                return *_p;
+            }
 
-            const elemType& operator*() const {
-                return *(_palloc->data(_idx));
+            inline const elemType* operator->() const {
+                return &**this;
             }
 
-            const_iterator& operator++() {
-                if (_palloc->has_value(_idx)) ++_idx;
+            inline const elemType& operator[](ptrdiff_t offset) const {
+                return *(*this + offset);
+            }
+
+            inline const_iterator& operator++() noexcept {
+                ++_p;
                 return *this;
             }
 
-            const_iterator operator++(int) {
-                iterator iter(*this);
-                ++(*this);
+            inline const_iterator operator++(int) noexcept {
+                const_iterator iter(*this);
+                ++_p;
                 return iter;
             }
 
-            const_iterator& operator--() {
-                if (_idx) --_idx;
-                else throw sjtu::invalid_iterator();
+            inline const_iterator& operator--() noexcept {
+                --_p;
                 return *this;
             }
 
-            const_iterator& operator+=(int offset) {
-                _idx += offset;
+            inline const_iterator operator--(int) noexcept {
+                const_iterator iter(*this);
+                --_p;
+                return iter;
+            }
+
+            inline const_iterator& operator+=(ptrdiff_t offset) noexcept {
+                _p += offset;
                 return *this;
             }
 
-            const_iterator& operator-=(int offset) {
-                _idx -= offset;
+            inline const_iterator& operator-=(ptrdiff_t offset) noexcept {
+                _p -= offset;
                 return *this;
             }
 
-            const_iterator operator--(int) {
-                iterator iter(*this);
-                --(*this);
-                return iter;
+            inline const_iterator operator+(ptrdiff_t offset) const noexcept {
+                const_iterator iter(*this);
+                return iter += offset;
             }
 
-            const_iterator operator+(int offset) {
-                return const_iterator(_palloc, _idx + offset);
+            friend inline const_iterator operator+(ptrdiff_t offset, const const_iterator& iter) noexcept {
+                return iter + offset;
             }
 
-            const_iterator operator-(int offset) {
-                return const_iterator(_palloc, _idx - offset);
+            inline const_iterator operator-(ptrdiff_t offset) const noexcept {
+                const_iterator iter(*this);
+                return iter -= offset;
             }
 
-            friend long long operator-(const const_iterator& lhs, const const_iterator& rhs) {
-                if (lhs._palloc != rhs._palloc) throw sjtu::invalid_iterator();
-                return (long long)lhs._idx - rhs._idx;
+            friend inline ptrdiff_t operator-(const const_iterator& lhs, const const_iterator& rhs) {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+                lhs._check_same(rhs);
+#endif
+                return lhs._p - rhs._p;
             }
 
-            bool operator==(const const_iterator& rhs) const {
-                if (_palloc != rhs._palloc) throw sjtu::invalid_iterator();
-                return _palloc == rhs._palloc && _idx == rhs._idx;
+            inline bool operator==(const const_iterator& rhs) const {
+#ifdef VECTOR_ITERATOR_CHECK_ENABLED
+                _check_same(rhs);
+#endif
+                return _p == rhs._p;
             }
 
-            bool operator!=(const const_iterator& rhs) const {
-                if (_palloc != rhs._palloc) throw sjtu::invalid_iterator();
+            inline bool operator!=(const const_iterator& rhs) const {
                 return !(*this == rhs);
             }
+
+            inline bool operator<(const const_iterator& rhs) const {
+                return *this - rhs < 0;
+            }
+
+            inline bool operator>(const const_iterator& rhs) const {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const const_iterator& rhs) const {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const const_iterator& rhs) const {
+                return !(*this < rhs);
+            }
         };
 
-        vector() noexcept : _allocator(10), _size(0) {}
+        vector() noexcept : _allocator(MIN_CAPACITY), _size(0) {}
+
+        // empty vector whose allocator is built from alloc_arg, e.g. the
+        // std::pmr::memory_resource* of a __pmr_allocator
+        template <class Arg, class = std::enable_if_t<
+            std::is_constructible<Allocator, size_t, Arg&&>::value>>
+        explicit vector(Arg&& alloc_arg) :
+            _allocator(MIN_CAPACITY, Forward<Arg>(alloc_arg)), _size(0) {}
 
 #ifdef VECTOR_INITIALIZER_LIST_ENABLED
         vector(std::initializer_list<elemType> list) :
-            _allocator(val_max(list.size() * 2), 10), _size(list.size()) {
-            for (auto i = list.begin(); i != list.end(); ++i) {
-                _allocator.construct(i - list.begin(), *i);
-            }
+            _allocator(val_max(list.size(), MIN_CAPACITY)), _size(0) {
+            _insert_range(0, list.begin(), list.size());
         }
 #endif
 
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        vector(InputIt first, InputIt last) :
+            vector() {
+            append(first, last);
+        }
+
         vector(size_t num, const elemType& value) :
-            _allocator(val_max(num * 2, 10)), _size(num) {
+            _allocator(val_max(num, MIN_CAPACITY)), _size(num) {
             for (size_t i = 0; i < _size; ++i) {
                 _allocator.construct(i, value);
             }
@@ -190,7 +438,7 @@ namespace s7a9 {
         }
 
         vector(vector&& x) noexcept :
-            _allocator(Move(x._allocator)), _size(x.size) {
+            _allocator(Move(x._allocator)), _size(x._size) {
             x._size = 0;
         }
 
@@ -198,11 +446,7 @@ namespace s7a9 {
 
         vector& operator= (const vector& rhs) {
             if (this == &rhs) return *this;
-            _allocator.clean();
-            _allocator.reallocate(rhs._allocator.length());
-            for (size_t i = 0; i < rhs._size; ++i) {
-                _allocator.construct(i, rhs[i]);
-            }
+            _allocator.copy(rhs._allocator);
             _size = rhs._size;
             return *this;
         }
@@ -210,16 +454,14 @@ namespace s7a9 {
         vector& operator= (vector&& rhs) {
             if (this == &rhs) return *this;
             _allocator.clean();
-            _allocator.reallocate(rhs._allocator.length());
-            for (size_t i = 0; i < rhs._size; ++i) {
-                _allocator.construct(i, Move(rhs[i]));
-            }
+            _allocator.swap(rhs._allocator);
             _size = rhs._size;
+            rhs._size = 0;
             return *this;
         }
 
         [[nodiscard]] bool empty() const noexcept {
-            return _size > 0;
+            return _size == 0;
         }
 
         size_t size() const noexcept {
@@ -230,19 +472,39 @@ namespace s7a9 {
             return _allocator.length();
         }
 
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        // allocation counters of the underlying allocator
+        alloc_stats stats() const {
+            return _allocator.stats();
+        }
+#endif
+
+        // make the capacity at least num without changing the size
+        void reserve(size_t num) {
+            if (num > _allocator.length() && _allocator.reallocate(num) == nullptr) throw std::bad_alloc();
+        }
+
+        // value-initialize new elements or destroy the ones past sz
         void resize(size_t sz) {
-            _allocator.reallocate(sz);
+            _grow(sz);
+            for (; _size < sz; ++_size)
+                _allocator.emplace(_size);
+            while (_size > sz)
+                _allocator.remove(--_size);
         }
 
         void resize(size_t sz, const elemType& value) {
-            _allocator.reallocate(sz, value);
+            _grow(sz);
+            for (; _size < sz; ++_size)
+                _allocator.construct(_size, value);
+            while (_size > sz)
+                _allocator.remove(--_size);
         }
 
+        // drop the unused capacity
         void shrink_to_fit() {
-            if (_size * 2 < 10)
-                _allocator.reallocate(10);
-            else
-                _allocator.reallocate(_size * 2);
+            size_t cap = val_max(_size, 1);
+            if (cap < _allocator.length()) _allocator.reallocate(cap);
         }
 
         elemType& operator[](size_t idx) {
@@ -293,63 +555,72 @@ namespace s7a9 {
             return _allocator[0];
         }
 
+        // data() carrying the alignment of the allocator's blocks, so that the
+        // compiler may use aligned SIMD loads and stores
+        elemType* aligned_data() {
+            return assume_aligned<__block_alignment<Allocator>::value>(_allocator[0]);
+        }
+
+        const elemType* aligned_data() const {
+            return assume_aligned<__block_alignment<Allocator>::value>(_allocator[0]);
+        }
+
         void push_back(const elemType& x) {
-            if (_allocator.length() == _size + 1) {
-                _allocator.reallocate(_allocator.length() * 2);
-            }
+            _grow(_size + 1);
             _allocator.construct(_size, x);
             ++_size;
         }
 
         void push_back(elemType&& x) {
-            if (_allocator.length() == _size + 1) {
-                _allocator.reallocate(_allocator.length() * 2);
-            }
-            _allocator.construct(_size, x);
+            _grow(_size + 1);
+            _allocator.construct(_size, Move(x));
             ++_size;
         }
 
+        template <class... Args>
+        elemType& emplace_back(Args&&... args) {
+            _grow(_size + 1);
+            _allocator.emplace(_size, Forward<Args>(args)...);
+            return *(_allocator[_size++]);
+        }
+
         void pop_back() {
             --_size;
             _allocator.remove(_size);
         }
 
         iterator begin() noexcept {
-            return iterator(&_allocator, 0);
+            return iterator(_begin(), this);
         }
 
         const_iterator begin() const noexcept {
-            return const_iterator(&_allocator, 0);
+            return const_iterator(_begin(), this);
         }
 
         const_iterator cbegin() const noexcept {
-            return const_iterator(&_allocator, 0);
+            return const_iterator(_begin(), this);
         }
 
         iterator end() noexcept {
-            return iterator(&_allocator, _size);
+            return iterator(_begin() + _size, this);
         }
 
         const_iterator end() const noexcept {
-            return const_iterator(&_allocator, _size);
+            return const_iterator(_begin() + _size, this);
         }
 
         const_iterator cend() const noexcept {
-            return const_iterator(&_allocator, _size);
+            return const_iterator(_begin() + _size, this);
         }
 
         iterator insert(const_iterator position, const elemType& x) {
-            if (_allocator.length() == _size + 1) {
-                _allocator.reallocate(_allocator.length() * 2);
-            }
-            size_t pos = position._idx;
+            size_t pos = _index(position);
             if (pos > _size) throw sjtu::index_out_of_bound();
-            for (size_t i = _size; i > pos; --i) {
-                _allocator.move_elem(i, i - 1);
-            }
+            _grow(_size + 1);
+            _allocator.move_range(pos + 1, pos, _size - pos);
             _allocator.construct(pos, x);
             ++_size;
-            return iterator(&_allocator, pos);
+            return iterator(_begin() + pos, this);
         }
 
         iterator insert(size_t index, const elemType& x) {
@@ -357,37 +628,99 @@ namespace s7a9 {
         }
 
         iterator insert(size_t index, elemType&& x) {
-            return insert(begin() + index, x);
+            return insert(begin() + index, Move(x));
         }
 
         iterator insert(const_iterator position, elemType&& x) {
-            if (_allocator.length() == _size + 1) {
-                _allocator.reallocate(_allocator.length() * 2);
-            }
-            size_t pos = position._idx;
+            size_t pos = _index(position);
             if (pos > _size) throw sjtu::index_out_of_bound();
-            for (size_t i = _size; i > pos; --i) {
-                _allocator.move_elem(i, i - 1);
-            }
-            _allocator.construct(pos, x);
+            _grow(_size + 1);
+            _allocator.move_range(pos + 1, pos, _size - pos);
+            _allocator.construct(pos, Move(x));
             ++_size;
-            return iterator(&_allocator, pos);
+            return iterator(_begin() + pos, this);
+        }
+
+        // construct an element in place before position
+        template <class... Args>
+        iterator emplace(const_iterator position, Args&&... args) {
+            size_t pos = _index(position);
+            if (pos > _size) throw sjtu::index_out_of_bound();
+            _grow(_size + 1);
+            _allocator.move_range(pos + 1, pos, _size - pos);
+            _allocator.emplace(pos, Forward<Args>(args)...);
+            ++_size;
+            return iterator(_begin() + pos, this);
+        }
+
+        // insert copies of [first, last) before position: the capacity grows at
+        // most once, the tail is shifted once, and trivially copyable elements
+        // from a pointer range are copied with memcpy(). Single-pass input
+        // ranges are appended and rotated into place instead. [first, last)
+        // must not point into this vector.
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        iterator insert(const_iterator position, InputIt first, InputIt last) {
+            size_t pos = _index(position);
+            if (pos > _size) throw sjtu::index_out_of_bound();
+            if constexpr (__is_iterator<InputIt, std::forward_iterator_tag>::value) {
+                _insert_range(pos, _raw(first), std::distance(first, last));
+            }
+            else {
+                size_t old_size = _size;
+                for (; first != last; ++first)
+                    emplace_back(*first);
+                std::rotate(_begin() + pos, _begin() + old_size, _begin() + _size);
+            }
+            return iterator(_begin() + pos, this);
+        }
+
+        // append copies of [first, last), see insert()
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        void append(InputIt first, InputIt last) {
+            insert(cend(), first, last);
+        }
+
+        // replace the contents with copies of [first, last), keeping the capacity
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        void assign(InputIt first, InputIt last) {
+            clear();
+            insert(cend(), first, last);
+        }
+
+        void assign(size_t n, const elemType& x) {
+            clear();
+            insert(cend(), n, x);
         }
 
+#ifdef VECTOR_INITIALIZER_LIST_ENABLED
+        iterator insert(const_iterator position, std::initializer_list<elemType> list) {
+            return insert(position, list.begin(), list.end());
+        }
+
+        void append(std::initializer_list<elemType> list) {
+            insert(cend(), list.begin(), list.end());
+        }
+
+        void assign(std::initializer_list<elemType> list) {
+            assign(list.begin(), list.end());
+        }
+
+        vector& operator=(std::initializer_list<elemType> list) {
+            assign(list.begin(), list.end());
+            return *this;
+        }
+#endif
+
         iterator insert(const_iterator position, size_t n, const elemType& x) {
             if (n == 0) return end();
-            if (_allocator.length() <= _size + n) {
-                _allocator.reallocate((_size + n) * 2);
-            }
-            size_t pos = position._idx;
+            size_t pos = _index(position);
             if (pos > _size) throw sjtu::index_out_of_bound();
-            for (size_t i = _size; i > pos; --i) {
-                _allocator.move_elem(i + n - 1, i - 1);
-            }
+            _grow(_size + n);
+            _allocator.move_range(pos + n, pos, _size - pos);
             for (size_t i = 0; i < n; ++i)
                 _allocator.construct(pos + i, x);
             _size += n;
-            return iterator(&_allocator, pos + n - 1);
+            return iterator(_begin() + pos + n - 1, this);
         }
 
         iterator erase(size_t idx) {
@@ -395,38 +728,74 @@ namespace s7a9 {
         }
 
         iterator erase(const_iterator position) {
-            size_t pos = position._idx;
+            size_t pos = _index(position);
             if (pos >= _size) {
                 throw sjtu::index_out_of_bound();
             }
             _allocator.remove(pos);
             --_size;
-            for (size_t i = pos; i < _size; ++i) {
-                _allocator.move_elem(i, i + 1);
-            }
-            if (_size < _allocator.length() / 2 && _allocator.length() > 10) {
-                _allocator.reallocate(_allocator.length() / 2);
-            }
-            return iterator(&_allocator, pos);
+            _allocator.move_range(pos, pos + 1, _size - pos);
+            _shrink();
+            return iterator(_begin() + pos, this);
         }
 
         iterator erase(const_iterator first, const_iterator last) {
-            size_t pos1 = first._idx, pos2 = last._idx, i;
-            if (pos1 >= _size || pos2 >= _size) {
+            size_t pos1 = _index(first), pos2 = _index(last), i;
+            if (pos1 > pos2 || pos2 > _size) {
                 throw sjtu::index_out_of_bound();
             }
             for (i = pos1; i < pos2; ++i) {
                 _allocator.remove(i);
             }
-            while (pos2 < _size) {
-                _allocator.move_elem(pos1, pos2);
-                ++pos1, ++pos2;
-            }
+            _allocator.move_range(pos1, pos2, _size - pos2);
             _size -= pos2 - pos1;
-            if (_size < _allocator.length() / 2 && _allocator.length() > 10) {
-                _allocator.reallocate(_allocator.length() / 2);
-            }
-            return iterator(&_allocator, first._idx);
+            _shrink();
+            return iterator(_begin() + pos1, this);
+        }
+
+        // remove every element matching pred in one pass, keeping the order of
+        // the others, and return how many were removed. Trivially copyable
+        // elements are compacted without branching on pred.
+        template <class Pred>
+        size_t erase_if(Pred pred) {
+            elemType* p = _begin();
+            size_t kept = 0;
+            if constexpr (std::is_trivially_copyable<elemType>::value) {
+                for (size_t i = 0; i < _size; ++i) {
+                    elemType x = p[i];
+                    p[kept] = x;
+                    kept += !pred(x);
+                }
+            }
+            else {
+                while (kept < _size && !pred(p[kept])) ++kept;
+                for (size_t i = kept + 1; i < _size; ++i) {
+                    if (!pred(p[i])) p[kept++] = Move(p[i]);
+                }
+            }
+            size_t removed = _size - kept;
+            _allocator.remove_range(kept, _size);
+            _size = kept;
+            _shrink();
+            return removed;
+        }
+
+        // erase_if() that fills each hole with the last element instead of
+        // shifting, so the order of the remaining elements is not kept
+        template <class Pred>
+        size_t erase_if_unstable(Pred pred) {
+            elemType* p = _begin();
+            size_t old_size = _size;
+            for (size_t i = 0; i < _size;) {
+                if (!pred(p[i])) {
+                    ++i;
+                    continue;
+                }
+                if (i + 1 != _size) p[i] = Move(p[_size - 1]);
+                _allocator.remove(--_size);
+            }
+            _shrink();
+            return old_size - _size;
         }
 
         void swap(vector& x) {
@@ -434,12 +803,20 @@ namespace s7a9 {
             s7a9::swap(_size, x._size);
         }
 
+        // destroy every element, keeping the capacity
         void clear() noexcept {
             _allocator.clean();
-            _allocator.reallocate(10);
             _size = 0;
         }
     };
+
+    // vector keeping up to N elements inside the object: it allocates nothing
+    // until it outgrows N, and returns to the inline buffer when it shrinks
+    // back. Moving or swapping one that is still small moves its elements.
+    template <class elemType, size_t N = 8>
+    using small_vector = vector<elemType, __small_allocator<elemType, N>>;
 }
 
+#include "vector_bool.hpp"
+
 #endif // STLITE_VECTOR_HPP
\ No newline at end of file
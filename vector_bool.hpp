@@ -0,0 +1,957 @@
+#ifndef STLITE_VECTOR_BOOL_HPP
+#define STLITE_VECTOR_BOOL_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include "allocator.hpp"
+#include "exceptions.hpp"
+#include "vector.hpp"
+
+namespace s7a9 {
+    // Bit-packed vector<bool>
+    // Bits live in 64-bit words taken from the same kind of allocator as
+    // Allocator, one bit per element. Bits past size() are always zero, so
+    // count(), find_first()/find_next(), rank()/select() and the bitwise
+    // operators work a word at a time with popcount/ctz. Elements are accessed
+    // through the proxy type reference.
+    template <class Allocator>
+    class vector<bool, Allocator> {
+    public:
+        typedef unsigned long long word_t;
+
+        static constexpr size_t WORD_BITS = 64;
+
+        static constexpr size_t npos = size_t(-1);
+
+    private:
+        static constexpr size_t MIN_WORDS = 1;
+
+        typedef typename __rebind_allocator<Allocator, word_t>::type word_allocator;
+
+        static_assert(__is_contiguous<word_allocator>::value, "vector<bool>: the allocator must store slots contiguously");
+
+        word_allocator _words; // Every slot holds a word
+
+        size_t _size;
+
+        static inline size_t _word_num(size_t bits) noexcept {
+            return (bits + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        inline word_t* _data() noexcept {
+            return _words.data(0);
+        }
+
+        inline const word_t* _data() const noexcept {
+            return _words.data(0);
+        }
+
+        // resize the word block to num words, zeroing the new ones; throws
+        // bad_alloc and keeps the bits if memory runs out
+        void _reallocate(size_t num) {
+            size_t old_num = _words.length();
+            if (_words.reallocate(num) == nullptr) throw std::bad_alloc();
+            for (size_t i = old_num; i < num; ++i)
+                _words.construct(i, word_t(0));
+        }
+
+        // make room for bits elements, at least doubling the word count
+        inline void _grow(size_t bits) {
+            size_t num = _word_num(bits);
+            if (num > _words.length())
+                _reallocate(val_max(num, _words.length() * 2));
+        }
+
+        // set the bits of [first, last) to value
+        void _fill_bits(size_t first, size_t last, bool value) noexcept {
+            word_t* w = _data();
+            while (first < last) {
+                size_t off = first % WORD_BITS, len = val_min(WORD_BITS - off, last - first);
+                word_t mask = (len == WORD_BITS ? ~word_t(0) : (word_t(1) << len) - 1) << off;
+                if (value) w[first / WORD_BITS] |= mask;
+                else w[first / WORD_BITS] &= ~mask;
+                first += len;
+            }
+        }
+
+        // the 64 bits starting at bit idx; bits past the block read as zero
+        inline word_t _load(size_t idx) const noexcept {
+            const word_t* w = _data();
+            size_t i = idx / WORD_BITS, off = idx % WORD_BITS;
+            word_t ret = w[i] >> off;
+            if (off && i + 1 < _words.length()) ret |= w[i + 1] << (WORD_BITS - off);
+            return ret;
+        }
+
+        // write the low len (1 to 64) bits of bits at bit idx
+        inline void _store(size_t idx, word_t bits, size_t len) noexcept {
+            word_t* w = _data();
+            size_t i = idx / WORD_BITS, off = idx % WORD_BITS;
+            word_t mask = len == WORD_BITS ? ~word_t(0) : (word_t(1) << len) - 1;
+            bits &= mask;
+            w[i] = (w[i] & ~(mask << off)) | bits << off;
+            if (off + len > WORD_BITS) {
+                size_t shift = WORD_BITS - off;
+                w[i + 1] = (w[i + 1] & ~(mask >> shift)) | bits >> shift;
+            }
+        }
+
+        // copy the len bits at src to dst, a word at a time; the ranges may overlap
+        void _move_bits(size_t dst, size_t src, size_t len) noexcept {
+            if (dst < src) {
+                for (size_t off = 0; off < len; off += WORD_BITS)
+                    _store(dst + off, _load(src + off), val_min(WORD_BITS, len - off));
+            }
+            else if (dst > src) {
+                for (size_t end = len; end > 0;) {
+                    size_t n = val_min(WORD_BITS, end);
+                    end -= n;
+                    _store(dst + end, _load(src + end), n);
+                }
+            }
+        }
+
+        // open a gap of n zero bits at pos
+        void _open(size_t pos, size_t n) {
+            if (pos > _size) throw sjtu::index_out_of_bound();
+            _grow(_size + n);
+            _move_bits(pos + n, pos, _size - pos);
+            _fill_bits(pos, pos + n, false);
+            _size += n;
+        }
+
+        // remove the bits of [first, last)
+        void _close(size_t first, size_t last) noexcept {
+            _move_bits(first, last, _size - last);
+            _fill_bits(_size - (last - first), _size, false);
+            _size -= last - first;
+        }
+
+        // zero the bits of the last word past size()
+        inline void _trim() noexcept {
+            if (_size % WORD_BITS) _data()[_size / WORD_BITS] &= (word_t(1) << _size % WORD_BITS) - 1;
+        }
+
+        inline void _check(size_t idx) const {
+            if (idx >= _size) throw sjtu::index_out_of_bound();
+        }
+
+        // position of the k-th (0-based) set bit of w, which has more than k
+        static inline size_t _select_in_word(word_t w, size_t k) noexcept {
+            for (; k; --k) w &= w - 1;
+            return ctz64(w);
+        }
+
+    public:
+        class reference {
+        private:
+            word_t* _w;
+
+            word_t _mask;
+
+            friend class vector;
+
+            reference(word_t* w, size_t bit) noexcept :
+                _w(w), _mask(word_t(1) << bit) {}
+
+        public:
+            inline operator bool() const noexcept {
+                return *_w & _mask;
+            }
+
+            inline reference& operator=(bool value) noexcept {
+                if (value) *_w |= _mask;
+                else *_w &= ~_mask;
+                return *this;
+            }
+
+            inline reference& operator=(const reference& rhs) noexcept {
+                return *this = bool(rhs);
+            }
+
+            inline bool operator~() const noexcept {
+                return !bool(*this);
+            }
+
+            inline void flip() noexcept {
+                *_w ^= _mask;
+            }
+
+            // swap the referred bits, for algorithms such as std::sort
+            friend inline void swap(reference lhs, reference rhs) noexcept {
+                bool tmp = lhs;
+                lhs = bool(rhs);
+                rhs = tmp;
+            }
+        };
+
+        class iterator;
+
+        class const_iterator {
+        private:
+            const word_t* _w;
+
+            size_t _idx;
+
+            friend class vector;
+
+            const_iterator(const word_t* w, size_t idx) noexcept :
+                _w(w), _idx(idx) {}
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef bool value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const bool* pointer;
+            typedef bool reference;
+
+            const_iterator() noexcept : _w(nullptr), _idx(0) {}
+
+            const_iterator(const iterator& iter) noexcept :
+                _w(iter._w), _idx(iter._idx) {}
+
+            inline bool operator*() const noexcept {
+                return (_w[_idx / WORD_BITS] >> _idx % WORD_BITS) & 1;
+            }
+
+            inline bool operator[](ptrdiff_t offset) const noexcept {
+                return *(*this + offset);
+            }
+
+            inline const_iterator& operator++() noexcept {
+                ++_idx;
+                return *this;
+            }
+
+            inline const_iterator operator++(int) noexcept {
+                const_iterator iter(*this);
+                ++_idx;
+                return iter;
+            }
+
+            inline const_iterator& operator--() noexcept {
+                --_idx;
+                return *this;
+            }
+
+            inline const_iterator operator--(int) noexcept {
+                const_iterator iter(*this);
+                --_idx;
+                return iter;
+            }
+
+            inline const_iterator& operator+=(ptrdiff_t offset) noexcept {
+                _idx += offset;
+                return *this;
+            }
+
+            inline const_iterator& operator-=(ptrdiff_t offset) noexcept {
+                _idx -= offset;
+                return *this;
+            }
+
+            inline const_iterator operator+(ptrdiff_t offset) const noexcept {
+                return const_iterator(_w, _idx + offset);
+            }
+
+            friend inline const_iterator operator+(ptrdiff_t offset, const const_iterator& iter) noexcept {
+                return iter + offset;
+            }
+
+            inline const_iterator operator-(ptrdiff_t offset) const noexcept {
+                return const_iterator(_w, _idx - offset);
+            }
+
+            friend inline ptrdiff_t operator-(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+                return ptrdiff_t(lhs._idx) - ptrdiff_t(rhs._idx);
+            }
+
+            inline bool operator==(const const_iterator& rhs) const noexcept {
+                return _w == rhs._w && _idx == rhs._idx;
+            }
+
+            inline bool operator!=(const const_iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            inline bool operator<(const const_iterator& rhs) const noexcept {
+                return _idx < rhs._idx;
+            }
+
+            inline bool operator>(const const_iterator& rhs) const noexcept {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const const_iterator& rhs) const noexcept {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const const_iterator& rhs) const noexcept {
+                return !(*this < rhs);
+            }
+        };
+
+        class iterator {
+        private:
+            word_t* _w;
+
+            size_t _idx;
+
+            friend class vector;
+
+            friend class vector::const_iterator;
+
+            iterator(word_t* w, size_t idx) noexcept :
+                _w(w), _idx(idx) {}
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef bool value_type;
+            typedef ptrdiff_t difference_type;
+            typedef void pointer;
+            typedef typename vector::reference reference;
+
+            iterator() noexcept : _w(nullptr), _idx(0) {}
+
+            inline reference operator*() const noexcept {
+                return reference(_w + _idx / WORD_BITS, _idx % WORD_BITS);
+            }
+
+            inline reference operator[](ptrdiff_t offset) const noexcept {
+                return *(*this + offset);
+            }
+
+            inline iterator& operator++() noexcept {
+                ++_idx;
+                return *this;
+            }
+
+            inline iterator operator++(int) noexcept {
+                iterator iter(*this);
+                ++_idx;
+                return iter;
+            }
+
+            inline iterator& operator--() noexcept {
+                --_idx;
+                return *this;
+            }
+
+            inline iterator operator--(int) noexcept {
+                iterator iter(*this);
+                --_idx;
+                return iter;
+            }
+
+            inline iterator& operator+=(ptrdiff_t offset) noexcept {
+                _idx += offset;
+                return *this;
+            }
+
+            inline iterator& operator-=(ptrdiff_t offset) noexcept {
+                _idx -= offset;
+                return *this;
+            }
+
+            inline iterator operator+(ptrdiff_t offset) const noexcept {
+                return iterator(_w, _idx + offset);
+            }
+
+            friend inline iterator operator+(ptrdiff_t offset, const iterator& iter) noexcept {
+                return iter + offset;
+            }
+
+            inline iterator operator-(ptrdiff_t offset) const noexcept {
+                return iterator(_w, _idx - offset);
+            }
+
+            friend inline ptrdiff_t operator-(const iterator& lhs, const iterator& rhs) noexcept {
+                return ptrdiff_t(lhs._idx) - ptrdiff_t(rhs._idx);
+            }
+
+            inline bool operator==(const iterator& rhs) const noexcept {
+                return _w == rhs._w && _idx == rhs._idx;
+            }
+
+            inline bool operator!=(const iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            inline bool operator<(const iterator& rhs) const noexcept {
+                return _idx < rhs._idx;
+            }
+
+            inline bool operator>(const iterator& rhs) const noexcept {
+                return rhs < *this;
+            }
+
+            inline bool operator<=(const iterator& rhs) const noexcept {
+                return !(rhs < *this);
+            }
+
+            inline bool operator>=(const iterator& rhs) const noexcept {
+                return !(*this < rhs);
+            }
+        };
+
+        vector() :
+            _words(0), _size(0) {
+            _reallocate(MIN_WORDS);
+        }
+
+        // empty vector whose word allocator is built from alloc_arg
+        template <class Arg, class = std::enable_if_t<
+            std::is_constructible<word_allocator, size_t, Arg&&>::value>>
+        explicit vector(Arg&& alloc_arg) :
+            _words(0, Forward<Arg>(alloc_arg)), _size(0) {
+            _reallocate(MIN_WORDS);
+        }
+
+#ifdef VECTOR_INITIALIZER_LIST_ENABLED
+        vector(std::initializer_list<bool> list) :
+            vector() {
+            append(list.begin(), list.end());
+        }
+#endif
+
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        vector(InputIt first, InputIt last) :
+            vector() {
+            append(first, last);
+        }
+
+        explicit vector(size_t num, bool value = false) :
+            _words(0), _size(num) {
+            _reallocate(val_max(_word_num(num), MIN_WORDS));
+            if (value) {
+                word_t* w = _data();
+                for (size_t i = 0; i < _word_num(num); ++i) w[i] = ~word_t(0);
+                _trim();
+            }
+        }
+
+        vector(const vector& x) :
+            _words(x._words), _size(x._size) {}
+
+        vector(vector&& x) noexcept :
+            _words(Move(x._words)), _size(x._size) {
+            x._size = 0;
+        }
+
+        vector& operator=(const vector& rhs) {
+            if (this == &rhs) return *this;
+            _words.copy(rhs._words);
+            _size = rhs._size;
+            return *this;
+        }
+
+        vector& operator=(vector&& rhs) {
+            if (this == &rhs) return *this;
+            _words.swap(rhs._words);
+            s7a9::swap(_size, rhs._size);
+            rhs.clear();
+            return *this;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        size_t size() const noexcept {
+            return _size;
+        }
+
+        size_t capacity() const noexcept {
+            return _words.length() * WORD_BITS;
+        }
+
+        void reserve(size_t num) {
+            if (_word_num(num) > _words.length()) _reallocate(_word_num(num));
+        }
+
+        void resize(size_t sz, bool value = false) {
+            if (sz < _size) {
+                _fill_bits(sz, _size, false);
+                _size = sz;
+                return;
+            }
+            _grow(sz);
+            if (value) _fill_bits(_size, sz, true);
+            _size = sz;
+        }
+
+        void shrink_to_fit() {
+            size_t num = val_max(_word_num(_size), MIN_WORDS);
+            if (num < _words.length()) _words.reallocate(num);
+        }
+
+        // set every bit to zero and the size to 0, keeping the capacity
+        void clear() noexcept {
+            _fill_bits(0, _size, false);
+            _size = 0;
+        }
+
+        reference operator[](size_t idx) {
+            _check(idx);
+            return reference(_data() + idx / WORD_BITS, idx % WORD_BITS);
+        }
+
+        bool operator[](size_t idx) const {
+            return test(idx);
+        }
+
+        reference at(size_t idx) {
+            return (*this)[idx];
+        }
+
+        bool at(size_t idx) const {
+            return test(idx);
+        }
+
+        bool test(size_t idx) const {
+            _check(idx);
+            return (_data()[idx / WORD_BITS] >> idx % WORD_BITS) & 1;
+        }
+
+        reference front() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return (*this)[0];
+        }
+
+        bool front() const {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return test(0);
+        }
+
+        reference back() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return (*this)[_size - 1];
+        }
+
+        bool back() const {
+            if (_size == 0) throw sjtu::container_is_empty();
+            return test(_size - 1);
+        }
+
+#ifdef STLITE_ALLOCATOR_STATS_ENABLED
+        // allocation counters of the word allocator
+        alloc_stats stats() const {
+            return _words.stats();
+        }
+#endif
+
+        // the packed words; bit i of the vector is bit i % 64 of word i / 64
+        word_t* data() noexcept {
+            return _data();
+        }
+
+        const word_t* data() const noexcept {
+            return _data();
+        }
+
+        size_t word_count() const noexcept {
+            return _word_num(_size);
+        }
+
+        void set(size_t idx, bool value = true) {
+            (*this)[idx] = value;
+        }
+
+        void reset(size_t idx) {
+            (*this)[idx] = false;
+        }
+
+        void flip(size_t idx) {
+            (*this)[idx].flip();
+        }
+
+        // flip every bit
+        void flip() noexcept {
+            word_t* w = _data();
+            for (size_t i = 0; i < _word_num(_size); ++i) w[i] = ~w[i];
+            _trim();
+        }
+
+        void push_back(bool value) {
+            _grow(_size + 1);
+            if (value) _data()[_size / WORD_BITS] |= word_t(1) << _size % WORD_BITS;
+            ++_size;
+        }
+
+        template <class... Args>
+        reference emplace_back(Args&&... args) {
+            push_back(bool(Forward<Args>(args)...));
+            return (*this)[_size - 1];
+        }
+
+        void pop_back() {
+            if (_size == 0) throw sjtu::container_is_empty();
+            --_size;
+            _data()[_size / WORD_BITS] &= ~(word_t(1) << _size % WORD_BITS);
+        }
+
+        iterator insert(const_iterator position, bool value) {
+            size_t pos = position._idx;
+            _open(pos, 1);
+            if (value) _data()[pos / WORD_BITS] |= word_t(1) << pos % WORD_BITS;
+            return iterator(_data(), pos);
+        }
+
+        iterator insert(size_t index, bool value) {
+            return insert(cbegin() + index, value);
+        }
+
+        template <class... Args>
+        iterator emplace(const_iterator position, Args&&... args) {
+            return insert(position, bool(Forward<Args>(args)...));
+        }
+
+        // insert n copies of value before position; like the generic vector,
+        // return an iterator to the last one inserted, or end() if n is 0
+        iterator insert(const_iterator position, size_t n, bool value) {
+            if (n == 0) return end();
+            size_t pos = position._idx;
+            _open(pos, n);
+            if (value) _fill_bits(pos, pos + n, true);
+            return iterator(_data(), pos + n - 1);
+        }
+
+        // insert copies of [first, last) before position, shifting the tail
+        // once; single-pass input ranges are gathered first
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        iterator insert(const_iterator position, InputIt first, InputIt last) {
+            size_t pos = position._idx;
+            if constexpr (__is_iterator<InputIt, std::forward_iterator_tag>::value) {
+                _open(pos, std::distance(first, last));
+                word_t* w = _data();
+                for (size_t i = pos; first != last; ++first, ++i)
+                    if (*first) w[i / WORD_BITS] |= word_t(1) << i % WORD_BITS;
+            }
+            else {
+                vector tmp;
+                for (; first != last; ++first) tmp.push_back(*first);
+                _open(pos, tmp._size);
+                _move_from(pos, tmp);
+            }
+            return iterator(_data(), pos);
+        }
+
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        void append(InputIt first, InputIt last) {
+            insert(cend(), first, last);
+        }
+
+        template <class InputIt, class = std::enable_if_t<__is_iterator<InputIt>::value>>
+        void assign(InputIt first, InputIt last) {
+            clear();
+            insert(cend(), first, last);
+        }
+
+        void assign(size_t n, bool value) {
+            clear();
+            insert(cend(), n, value);
+        }
+
+#ifdef VECTOR_INITIALIZER_LIST_ENABLED
+        iterator insert(const_iterator position, std::initializer_list<bool> list) {
+            return insert(position, list.begin(), list.end());
+        }
+
+        void append(std::initializer_list<bool> list) {
+            insert(cend(), list.begin(), list.end());
+        }
+
+        void assign(std::initializer_list<bool> list) {
+            assign(list.begin(), list.end());
+        }
+
+        vector& operator=(std::initializer_list<bool> list) {
+            assign(list.begin(), list.end());
+            return *this;
+        }
+#endif
+
+        iterator erase(size_t idx) {
+            return erase(cbegin() + idx);
+        }
+
+        iterator erase(const_iterator position) {
+            size_t pos = position._idx;
+            if (pos >= _size) throw sjtu::index_out_of_bound();
+            _close(pos, pos + 1);
+            return iterator(_data(), pos);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            size_t pos1 = first._idx, pos2 = last._idx;
+            if (pos1 > pos2 || pos2 > _size) throw sjtu::index_out_of_bound();
+            _close(pos1, pos2);
+            return iterator(_data(), pos1);
+        }
+
+        // remove every element matching pred in one pass, keeping the order of
+        // the others, and return how many were removed
+        template <class Pred>
+        size_t erase_if(Pred pred) {
+            word_t* w = _data();
+            size_t kept = 0;
+            for (size_t i = 0; i < _size; ++i) {
+                bool x = (w[i / WORD_BITS] >> i % WORD_BITS) & 1;
+                if (pred(x)) continue;
+                word_t bit = word_t(1) << kept % WORD_BITS;
+                if (x) w[kept / WORD_BITS] |= bit;
+                else w[kept / WORD_BITS] &= ~bit;
+                ++kept;
+            }
+            size_t removed = _size - kept;
+            _fill_bits(kept, _size, false);
+            _size = kept;
+            return removed;
+        }
+
+        // equal bits are interchangeable, so the stable pass is no slower
+        template <class Pred>
+        size_t erase_if_unstable(Pred pred) {
+            return erase_if(pred);
+        }
+
+        iterator begin() noexcept {
+            return iterator(_data(), 0);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(_data(), 0);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return const_iterator(_data(), 0);
+        }
+
+        iterator end() noexcept {
+            return iterator(_data(), _size);
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(_data(), _size);
+        }
+
+        const_iterator cend() const noexcept {
+            return const_iterator(_data(), _size);
+        }
+
+        // number of set bits
+        size_t count() const noexcept {
+            const word_t* w = _data();
+            size_t ret = 0;
+            for (size_t i = 0; i < _word_num(_size); ++i) ret += popcount64(w[i]);
+            return ret;
+        }
+
+        bool any() const noexcept {
+            const word_t* w = _data();
+            for (size_t i = 0; i < _word_num(_size); ++i)
+                if (w[i]) return true;
+            return false;
+        }
+
+        bool none() const noexcept {
+            return !any();
+        }
+
+        bool all() const noexcept {
+            return count() == _size;
+        }
+
+        // index of the first set bit, or npos
+        size_t find_first() const noexcept {
+            return _find_from(0);
+        }
+
+        // index of the first set bit after idx, or npos
+        size_t find_next(size_t idx) const noexcept {
+            return idx + 1 >= _size ? npos : _find_from(idx + 1);
+        }
+
+        // number of set bits in [0, idx)
+        size_t rank(size_t idx) const noexcept {
+            const word_t* w = _data();
+            idx = val_min(idx, _size);
+            size_t ret = 0;
+            for (size_t i = 0; i < idx / WORD_BITS; ++i) ret += popcount64(w[i]);
+            if (idx % WORD_BITS) ret += popcount64(w[idx / WORD_BITS] & ((word_t(1) << idx % WORD_BITS) - 1));
+            return ret;
+        }
+
+        // index of the k-th (0-based) set bit, or npos if there are at most k
+        size_t select(size_t k) const noexcept {
+            const word_t* w = _data();
+            for (size_t i = 0; i < _word_num(_size); ++i) {
+                size_t num = popcount64(w[i]);
+                if (k < num) return i * WORD_BITS + _select_in_word(w[i], k);
+                k -= num;
+            }
+            return npos;
+        }
+
+        // bitwise operators on vectors of the same size
+        vector& operator&=(const vector& rhs) {
+            if (rhs._size != _size) throw sjtu::runtime_error();
+            word_t* w = _data();
+            const word_t* r = rhs._data();
+            for (size_t i = 0; i < _word_num(_size); ++i) w[i] &= r[i];
+            return *this;
+        }
+
+        vector& operator|=(const vector& rhs) {
+            if (rhs._size != _size) throw sjtu::runtime_error();
+            word_t* w = _data();
+            const word_t* r = rhs._data();
+            for (size_t i = 0; i < _word_num(_size); ++i) w[i] |= r[i];
+            return *this;
+        }
+
+        vector& operator^=(const vector& rhs) {
+            if (rhs._size != _size) throw sjtu::runtime_error();
+            word_t* w = _data();
+            const word_t* r = rhs._data();
+            for (size_t i = 0; i < _word_num(_size); ++i) w[i] ^= r[i];
+            return *this;
+        }
+
+        friend vector operator&(vector lhs, const vector& rhs) {
+            return lhs &= rhs;
+        }
+
+        friend vector operator|(vector lhs, const vector& rhs) {
+            return lhs |= rhs;
+        }
+
+        friend vector operator^(vector lhs, const vector& rhs) {
+            return lhs ^= rhs;
+        }
+
+        vector operator~() const {
+            vector ret(*this);
+            ret.flip();
+            return ret;
+        }
+
+        bool operator==(const vector& rhs) const noexcept {
+            if (_size != rhs._size) return false;
+            const word_t* w = _data(), * r = rhs._data();
+            for (size_t i = 0; i < _word_num(_size); ++i)
+                if (w[i] != r[i]) return false;
+            return true;
+        }
+
+        bool operator!=(const vector& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+
+        void swap(vector& x) {
+            _words.swap(x._words);
+            s7a9::swap(_size, x._size);
+        }
+
+    private:
+        // copy the bits of x over [pos, pos + x.size())
+        void _move_from(size_t pos, const vector& x) noexcept {
+            for (size_t off = 0; off < x._size; off += WORD_BITS)
+                _store(pos + off, x._data()[off / WORD_BITS], val_min(WORD_BITS, x._size - off));
+        }
+
+        size_t _find_from(size_t idx) const noexcept {
+            if (idx >= _size) return npos;
+            const word_t* w = _data();
+            size_t i = idx / WORD_BITS;
+            word_t bits = w[i] & (~word_t(0) << idx % WORD_BITS);
+            while (bits == 0) {
+                if (++i >= _word_num(_size)) return npos;
+                bits = w[i];
+            }
+            return i * WORD_BITS + ctz64(bits);
+        }
+    };
+
+    // Rank/select directory over a vector<bool>
+    // Keeps the number of set bits before every block of BLOCK_WORDS words
+    // (one counter per 512 bits), so rank() is O(1) and select() is a binary
+    // search over the blocks. The directory refers to the words of the vector
+    // and must be rebuilt after the vector changes.
+    class bit_rank_index {
+    private:
+        typedef unsigned long long word_t;
+
+        static constexpr size_t WORD_BITS = 64, BLOCK_WORDS = 8, BLOCK_BITS = WORD_BITS * BLOCK_WORDS;
+
+        const word_t* _w;
+
+        size_t _size;
+
+        vector<size_t> _blocks; // _blocks[b]: set bits before block b; one extra entry for the total
+
+        inline size_t _word_num() const noexcept {
+            return (_size + WORD_BITS - 1) / WORD_BITS;
+        }
+
+    public:
+        static constexpr size_t npos = size_t(-1);
+
+        template <class Allocator>
+        explicit bit_rank_index(const vector<bool, Allocator>& bits) {
+            build(bits);
+        }
+
+        template <class Allocator>
+        void build(const vector<bool, Allocator>& bits) {
+            _w = bits.data(), _size = bits.size();
+            _blocks.clear();
+            _blocks.reserve(_word_num() / BLOCK_WORDS + 2);
+            size_t total = 0;
+            for (size_t i = 0; i < _word_num(); ++i) {
+                if (i % BLOCK_WORDS == 0) _blocks.push_back(total);
+                total += popcount64(_w[i]);
+            }
+            _blocks.push_back(total);
+        }
+
+        // number of set bits
+        size_t count() const noexcept {
+            return _blocks[_blocks.size() - 1];
+        }
+
+        // number of set bits in [0, idx)
+        size_t rank(size_t idx) const noexcept {
+            if (idx >= _size) return count();
+            size_t word = idx / WORD_BITS, ret = _blocks[idx / BLOCK_BITS];
+            for (size_t i = word / BLOCK_WORDS * BLOCK_WORDS; i < word; ++i) ret += popcount64(_w[i]);
+            if (idx % WORD_BITS) ret += popcount64(_w[word] & ((word_t(1) << idx % WORD_BITS) - 1));
+            return ret;
+        }
+
+        // index of the k-th (0-based) set bit, or npos if there are at most k
+        size_t select(size_t k) const noexcept {
+            if (k >= count()) return npos;
+            size_t lo = 0, hi = _blocks.size() - 1; // the block is the last one with _blocks[b] <= k
+            while (hi - lo > 1) {
+                size_t mid = (lo + hi) / 2;
+                if (_blocks[mid] <= k) lo = mid;
+                else hi = mid;
+            }
+            k -= _blocks[lo];
+            for (size_t i = lo * BLOCK_WORDS;; ++i) {
+                size_t num = popcount64(_w[i]);
+                if (k < num) {
+                    word_t w = _w[i];
+                    for (; k; --k) w &= w - 1;
+                    return i * WORD_BITS + ctz64(w);
+                }
+                k -= num;
+            }
+        }
+    };
+}
+
+#endif // STLITE_VECTOR_BOOL_HPP